@@ -0,0 +1,78 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "CatalogColumns.h"
+
+using namespace std;
+
+/**
+ * Recycling
+ * 
+ * A full export is hundreds of megabytes, and on a fresh allocation the kernel
+ * has to fault in every page of it, which costs about as much as the copy. Emptying
+ * the vectors of a previous export instead keeps their capacity, so repeated
+ * exports write into memory that is already mapped.
+ */
+CatalogColumnsBuilder::CatalogColumnsBuilder(CatalogColumns recycled) : columns(std::move(recycled)) {
+    columns.ids.clear();
+    columns.types.clear();
+    columns.shelves.clear();
+    columns.compartments.clear();
+    columns.checkedOut.clear();
+    columns.dueDays.clear();
+    columns.names.clear();
+    columns.creators.clear();
+    columns.descriptionOffsets.clear();
+    columns.titleOffsets.clear();
+    columns.issuedOffsets.clear();
+    columns.characters.clear();
+    columns.actorOffsets.assign(1, 0);
+    columns.actors.clear();
+}
+
+void CatalogColumnsBuilder::reserve(size_t rows) {
+    const size_t total = columns.size() + rows;
+    columns.ids.reserve(total);
+    columns.types.reserve(total);
+    columns.shelves.reserve(total);
+    columns.compartments.reserve(total);
+    columns.checkedOut.reserve(total);
+    columns.dueDays.reserve(total);
+    columns.names.reserve(total);
+    columns.creators.reserve(total);
+    columns.descriptionOffsets.reserve(total + 1);
+    columns.titleOffsets.reserve(total);
+    columns.issuedOffsets.reserve(total);
+    columns.actorOffsets.reserve(total + 1);
+}
+
+void CatalogColumnsBuilder::addRow(const Item& item, ItemType type, const Row& row,
+                                   Symbol creator, string_view title, string_view issuedText, span<const Symbol> actorList) {
+    columns.ids.push_back(item.getID());
+    columns.types.push_back(type);
+    columns.shelves.push_back(row.pos.getRow());
+    columns.compartments.push_back(row.pos.getCol());
+    columns.checkedOut.push_back(row.isCheckedOut ? 1 : 0);
+    columns.dueDays.push_back(row.dueDay);
+    columns.names.push_back(item.getNameSymbol());
+    columns.creators.push_back(creator);
+
+    string& text = columns.characters;
+    columns.descriptionOffsets.push_back(text.size());
+    text += item.getDescription();
+    columns.titleOffsets.push_back(text.size());
+    text += title;
+    columns.issuedOffsets.push_back(text.size());
+    text += issuedText;
+
+    if (!actorList.empty()) {
+        columns.actors.insert(columns.actors.end(), actorList.begin(), actorList.end());
+    }
+    columns.actorOffsets.push_back(columns.actors.size());
+}
+
+CatalogColumns CatalogColumnsBuilder::finish() && {
+    columns.descriptionOffsets.push_back(columns.characters.size());
+    return std::move(columns);
+}
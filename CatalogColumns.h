@@ -0,0 +1,144 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef CATALOGCOLUMNS_H
+#define CATALOGCOLUMNS_H
+
+#include "Item.h"
+#include "ItemStorage.h"
+#include "Position.h"
+#include "SymbolTable.h"
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+/// Concrete type of an exported item
+enum class ItemType : uint8_t { Item, Book, Magazine, Movie };
+
+/**
+ * @struct CatalogColumns
+ * @brief The catalog as one array per field, for analytics
+ *
+ * Row i of every column describes the same item. Shelved items come first in
+ * shelf order, then the checked-out items, which report the compartment they
+ * belong in. Fixed-size fields are plain arrays that can be scanned one column
+ * at a time. Interned fields are exported as their Symbol, so equality filters
+ * compare integers; SymbolTable::lookup turns a Symbol back into text.
+ *
+ * The free-text fields share one character buffer, written row by row: the
+ * description, title and issued text of row 0, then those of row 1, and so on.
+ * Each field has a column of offsets at which its text starts, and its text
+ * ends where the next field's starts; descriptionOffsets has one extra entry,
+ * the size of the buffer, to end the last row. Movie actors are a list column:
+ * the actors of row i are actors[actorOffsets[i], actorOffsets[i + 1]).
+ */
+struct CatalogColumns {
+    /// dueDays value of an item that is on its shelf, so "dueDays < today" needs no mask
+    static constexpr int32_t notDue = numeric_limits<int32_t>::max();
+
+    vector<ItemId> ids;
+    vector<ItemType> types;
+    vector<int32_t> shelves;
+    vector<int32_t> compartments;
+    vector<uint8_t> checkedOut;   ///< 1 if the item is checked out
+    vector<int32_t> dueDays;      ///< Due date as days since 1970-01-01, or notDue
+    vector<Symbol> names;
+    vector<Symbol> creators;      ///< Book author or movie director, otherwise SymbolTable::empty
+
+    vector<uint64_t> descriptionOffsets; ///< One entry per row plus the end of the buffer
+    vector<uint64_t> titleOffsets;
+    vector<uint64_t> issuedOffsets;      ///< Book copyright date or magazine edition
+    string characters;
+
+    vector<uint64_t> actorOffsets;
+    vector<Symbol> actors;
+
+    /// @return Number of rows
+    size_t size() const { return ids.size(); }
+
+    string_view description(size_t row) const { return text(descriptionOffsets[row], titleOffsets[row]); }
+    string_view title(size_t row) const { return text(titleOffsets[row], issuedOffsets[row]); }
+    string_view issued(size_t row) const { return text(issuedOffsets[row], descriptionOffsets[row + 1]); }
+
+    /// @return The actors of row, empty unless it is a movie
+    span<const Symbol> actorsOf(size_t row) const {
+        return span(actors).subspan(actorOffsets[row], actorOffsets[row + 1] - actorOffsets[row]);
+    }
+
+private:
+    string_view text(uint64_t begin, uint64_t end) const {
+        return string_view(characters).substr(begin, end - begin);
+    }
+};
+
+/**
+ * @class CatalogColumnsBuilder
+ * @brief Appends items to CatalogColumns one row at a time
+ */
+class CatalogColumnsBuilder {
+public:
+    /**
+     * @param recycled Columns whose memory is reused for the new rows; their
+     *        contents are discarded
+     */
+    explicit CatalogColumnsBuilder(CatalogColumns recycled = {});
+
+    /// @brief Makes room for rows more rows in every fixed-size column
+    void reserve(size_t rows);
+
+    /**
+     * @brief Appends one item
+     * @param item Item of any concrete type, or an Item reference to any of them
+     * @param pos Compartment the item is in, or belongs in if it is checked out
+     * @param isCheckedOut Whether the item is checked out
+     * @param dueDay Days since 1970-01-01 it is due, or CatalogColumns::notDue
+     */
+    template <typename T>
+    void add(const T& item, const Position& pos, bool isCheckedOut = false, int32_t dueDay = CatalogColumns::notDue) {
+        const Row row{pos, isCheckedOut, dueDay};
+        if constexpr (is_same_v<T, Item>) {
+            // A pooled item only has its base type statically
+            withConcreteItem(item, [&](const auto& concrete) { addConcrete(concrete, row); });
+        } else {
+            addConcrete(item, row);
+        }
+    }
+
+    /// @brief Ends the last row and hands over the columns
+    CatalogColumns finish() &&;
+
+private:
+    CatalogColumns columns;
+
+    /// Where an item is and whether it is out, as passed to add()
+    struct Row {
+        Position pos;
+        bool isCheckedOut;
+        int32_t dueDay;
+    };
+
+    void addRow(const Item& item, ItemType type, const Row& row,
+                Symbol creator, string_view title, string_view issuedText, span<const Symbol> actorList);
+
+    void addConcrete(const Item& item, const Row& row) {
+        addRow(item, ItemType::Item, row, SymbolTable::empty, {}, {}, {});
+    }
+    void addConcrete(const Book& book, const Row& row) {
+        addRow(book, ItemType::Book, row, book.getAuthorSymbol(), book.getTitle(), book.getCopyrightDate(), {});
+    }
+    void addConcrete(const Magazine& magazine, const Row& row) {
+        addRow(magazine, ItemType::Magazine, row, SymbolTable::empty, magazine.getTitle(), magazine.getEdition(), {});
+    }
+    void addConcrete(const Movie& movie, const Row& row) {
+        addRow(movie, ItemType::Movie, row, movie.getDirectorSymbol(), movie.getTitle(), {}, movie.getMainActorSymbols());
+    }
+};
+
+#endif //CATALOGCOLUMNS_H
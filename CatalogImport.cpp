@@ -0,0 +1,293 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "CatalogImport.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// Below this much text per thread, starting another thread costs more than it saves
+constexpr size_t minimumChunkBytes = size_t{1} << 20;
+
+/// One field of a row; escaped is set when a quoted field contains "" pairs
+struct Field {
+    string_view text;
+    bool escaped = false;
+};
+
+/**
+ * Splits one line into fields without copying them
+ *
+ * Quoted fields are returned without their quotes. Doubled quotes inside them
+ * are left in place and only collapsed when the field is turned into its final
+ * string, which keeps the common unquoted field a plain view into the file.
+ */
+class RowReader {
+public:
+    RowReader(string_view line, char delimiter) : line(line), delimiter(delimiter) {}
+
+    bool atEnd() const { return finished; }
+
+    Field next() {
+        if (finished) throw runtime_error("Too few fields");
+        Field field;
+        size_t end;
+        if (pos < line.size() && line[pos] == '"') {
+            size_t close = pos + 1;
+            while (true) {
+                close = line.find('"', close);
+                if (close == string_view::npos) throw runtime_error("Unterminated quoted field");
+                if (close + 1 < line.size() && line[close + 1] == '"') {
+                    field.escaped = true;
+                    close += 2;
+                } else {
+                    break;
+                }
+            }
+            field.text = line.substr(pos + 1, close - pos - 1);
+            end = close + 1;
+            if (end < line.size() && line[end] != delimiter) throw runtime_error("Unexpected text after quoted field");
+        } else {
+            end = min(line.find(delimiter, pos), line.size());
+            field.text = line.substr(pos, end - pos);
+        }
+        if (end >= line.size()) finished = true;
+        pos = end + 1;
+        return field;
+    }
+
+private:
+    string_view line;
+    char delimiter;
+    size_t pos = 0;
+    bool finished = false;
+};
+
+void appendUnescaped(string& out, string_view text) {
+    for (size_t i = 0; i < text.size(); i++) {
+        out += text[i];
+        if (text[i] == '"') i++; // Skip the second quote of each pair
+    }
+}
+
+/// Builds the string an item will own, collapsing doubled quotes on the way
+string toString(const Field& field) {
+    if (!field.escaped) return string(field.text);
+    string out;
+    out.reserve(field.text.size());
+    appendUnescaped(out, field.text);
+    return out;
+}
+
+/// Returns field as a view, unescaping into scratch only when it has to
+string_view toView(const Field& field, string& scratch) {
+    if (!field.escaped) return field.text;
+    scratch.clear();
+    appendUnescaped(scratch, field.text);
+    return scratch;
+}
+
+int toInt(const Field& field, const char* what) {
+    int value = 0;
+    const char* first = field.text.data();
+    const char* last = first + field.text.size();
+    auto [end, error] = from_chars(first, last, value);
+    if (error != errc() || end != last || first == last) {
+        throw runtime_error("Invalid " + string(what) + " \"" + string(field.text) + "\"");
+    }
+    return value;
+}
+
+bool equalsIgnoreCase(string_view a, string_view b) {
+    return a.size() == b.size() && equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return (x | 0x20) == (y | 0x20);
+    });
+}
+
+/**
+ * Parser state for one chunk
+ *
+ * The scratch strings are only touched by quoted fields with escapes, and are
+ * reused from row to row, so a clean catalog parses without them ever allocating.
+ */
+class ChunkParser {
+public:
+    ChunkParser(const CatalogOptions& options, char delimiter) : options(options), delimiter(delimiter) {}
+
+    pair<Position, ItemValue> parseRow(string_view line) {
+        RowReader row(line, delimiter);
+        ItemValue item = parseItem(row);
+        const int shelf = toInt(row.next(), "shelf");
+        const int compartment = toInt(row.next(), "compartment");
+        if (!row.atEnd()) throw runtime_error("Too many fields");
+        return {Position(shelf, compartment), std::move(item)};
+    }
+
+private:
+    const CatalogOptions& options;
+    char delimiter;
+    string nameScratch;
+    string personScratch;
+    string actorScratch;
+
+    /// Reads the type, the common fields and the type's own fields of a row
+    ItemValue parseItem(RowReader& row) {
+        const Field type = row.next();
+        const int id = toInt(row.next(), "item ID");
+        const Field name = row.next();
+        const Field description = row.next();
+
+        if (equalsIgnoreCase(type.text, "book")) {
+            const Field title = row.next();
+            const Field author = row.next();
+            const Field copyright = row.next();
+            return ItemValue(in_place_type<Book>, toView(name, nameScratch), toString(description), id,
+                toString(title), toView(author, personScratch), toString(copyright));
+        }
+        if (equalsIgnoreCase(type.text, "magazine")) {
+            const Field edition = row.next();
+            const Field title = row.next();
+            return ItemValue(in_place_type<Magazine>, toView(name, nameScratch), toString(description), id,
+                toString(edition), toString(title));
+        }
+        if (equalsIgnoreCase(type.text, "movie")) {
+            const Field title = row.next();
+            const Field director = row.next();
+            const Field actors = row.next();
+            return ItemValue(in_place_type<Movie>, toView(name, nameScratch), toString(description), id,
+                toString(title), toView(director, personScratch), parseActors(actors));
+        }
+        throw runtime_error("Unknown item type \"" + string(type.text) + "\"");
+    }
+
+    vector<Symbol> parseActors(const Field& field) {
+        const string_view list = toView(field, actorScratch);
+        vector<Symbol> actors;
+        if (list.empty()) return actors;
+        actors.reserve(count(list.begin(), list.end(), options.listSeparator) + 1);
+        for (size_t start = 0;;) {
+            const size_t end = min(list.find(options.listSeparator, start), list.size());
+            actors.push_back(SymbolTable::intern(list.substr(start, end - start)));
+            if (end == list.size()) break;
+            start = end + 1;
+        }
+        return actors;
+    }
+};
+
+struct ChunkResult {
+    CatalogRows rows;
+    size_t lines = 0;   // Lines consumed, including blank ones
+    string error;       // Empty unless a row failed
+};
+
+void parseChunk(string_view text, const CatalogOptions& options, char delimiter, ChunkResult& result) {
+    ChunkParser parser(options, delimiter);
+    // A catalog row is rarely shorter than this, so the estimate only errs high
+    result.rows.reserve(text.size() / 48 + 1);
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == string_view::npos) end = text.size();
+        string_view line = text.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        result.lines++;
+        start = end + 1;
+        if (line.empty()) continue;
+        try {
+            result.rows.push_back(parser.parseRow(line));
+        } catch (const exception& e) {
+            result.error = e.what();
+            return;
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * Parallel parse
+ *
+ * The text is cut into one chunk per thread, each cut moved forward to the next
+ * line break so that no row straddles two chunks. Every thread fills its own row
+ * vector, and the vectors are concatenated in chunk order afterwards, so the
+ * result is in file order whatever the thread count. Interning still goes through
+ * the SymbolTable's lock, but catalogs repeat their authors and actors heavily,
+ * so the critical section is a hash lookup rather than an allocation.
+ *
+ * If any row is malformed, the error reported is that of the earliest chunk; the
+ * chunks before it parsed completely, so their line counts give its line number.
+ */
+CatalogRows parseCatalog(string_view text, const CatalogOptions& options) {
+    const char delimiter = options.delimiter != 0 ? options.delimiter : ',';
+
+    size_t firstLine = 1;
+    if (options.hasHeader) {
+        const size_t headerEnd = text.find('\n');
+        text = headerEnd == string_view::npos ? string_view() : text.substr(headerEnd + 1);
+        firstLine = 2;
+    }
+
+    size_t threads = options.threads != 0 ? options.threads : max(1u, thread::hardware_concurrency());
+    threads = max<size_t>(1, min(threads, text.size() / minimumChunkBytes));
+
+    vector<string_view> chunks;
+    chunks.reserve(threads);
+    size_t start = 0;
+    for (size_t i = 1; i <= threads && start < text.size(); i++) {
+        size_t end = text.size();
+        if (i < threads) {
+            end = text.find('\n', max(start, text.size() / threads * i));
+            end = end == string_view::npos ? text.size() : end + 1;
+        }
+        chunks.push_back(text.substr(start, end - start));
+        start = end;
+    }
+
+    vector<ChunkResult> results(chunks.size());
+    {
+        vector<jthread> workers;
+        workers.reserve(chunks.size());
+        for (size_t i = 1; i < chunks.size(); i++) {
+            workers.emplace_back(parseChunk, chunks[i], cref(options), delimiter, ref(results[i]));
+        }
+        if (!chunks.empty()) parseChunk(chunks[0], options, delimiter, results[0]);
+    }
+
+    if (results.empty()) return {};
+
+    size_t line = firstLine;
+    size_t total = 0;
+    for (const ChunkResult& result : results) {
+        if (!result.error.empty()) {
+            throw runtime_error("Catalog line " + to_string(line + result.lines - 1) + ": " + result.error);
+        }
+        line += result.lines;
+        total += result.rows.size();
+    }
+
+    CatalogRows rows = std::move(results[0].rows);
+    rows.reserve(total);
+    for (size_t i = 1; i < results.size(); i++) {
+        move(results[i].rows.begin(), results[i].rows.end(), back_inserter(rows));
+    }
+    return rows;
+}
+
+CatalogRows readCatalog(const string& path, const CatalogOptions& options) {
+    CatalogOptions resolved = options;
+    if (resolved.delimiter == 0) {
+        const bool tsv = path.size() >= 4 && equalsIgnoreCase(string_view(path).substr(path.size() - 4), ".tsv");
+        resolved.delimiter = tsv ? '\t' : ',';
+    }
+    const MappedFile file(path);
+    return parseCatalog(file.text(), resolved);
+}
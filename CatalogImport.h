@@ -0,0 +1,82 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef CATALOGIMPORT_H
+#define CATALOGIMPORT_H
+
+#include "Inventory.h"
+#include "Item.h"
+#include "ItemStorage.h"
+#include "Position.h"
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @struct CatalogOptions
+ * @brief Controls how a catalog file is read
+ */
+struct CatalogOptions {
+    char delimiter = 0;       ///< Field separator; 0 picks tab for .tsv files and comma otherwise
+    char listSeparator = ';'; ///< Separates the actors within a movie's actor field
+    bool hasHeader = true;    ///< Skip the first line of the file
+    unsigned threads = 0;     ///< Parser threads; 0 uses one per hardware thread
+};
+
+/// Parsed catalog rows, ready to be handed to Inventory::addItems
+using CatalogRows = vector<pair<Position, ItemValue>>;
+
+/**
+ * @brief Parses catalog text into items and their positions
+ * @param text Whole catalog contents
+ * @param options Delimiters, header handling and thread count (a delimiter of 0 means comma)
+ * @return One entry per non-empty line, in file order
+ * @throws runtime_error naming the line of the first malformed row
+ *
+ * Each row starts with the item type and ID, followed by the fields of that type
+ * and finally the shelf and compartment:
+ *
+ *     book,id,name,description,title,author,copyrightDate,shelf,compartment
+ *     magazine,id,name,description,edition,title,shelf,compartment
+ *     movie,id,name,description,title,director,actors,shelf,compartment
+ *
+ * Fields may be wrapped in double quotes to contain the delimiter, with "" for a
+ * literal quote; a quoted field cannot span lines. The text is split into one
+ * chunk per thread at line boundaries and the chunks are parsed concurrently.
+ */
+CatalogRows parseCatalog(string_view text, const CatalogOptions& options = {});
+
+/**
+ * @brief Memory-maps a catalog file and parses it
+ * @param path Path of a CSV or TSV catalog
+ * @param options See parseCatalog
+ * @throws runtime_error if the file cannot be read or a row is malformed
+ */
+CatalogRows readCatalog(const string& path, const CatalogOptions& options = {});
+
+/**
+ * @brief Loads a catalog file into an inventory
+ * @param inventory Inventory to populate
+ * @param path Path of a CSV or TSV catalog
+ * @param options See parseCatalog
+ * @return Number of items added
+ * @throws runtime_error, out_of_range, invalid_argument as readCatalog and addItems do
+ *
+ * The rows are added with a single addItems call, so a catalog that collides with
+ * the inventory (or with itself) adds nothing at all. The parser hands over plain
+ * values and the inventory's storage policy places them, so with PooledStorage
+ * the items end up in the pool's slabs like any other added item.
+ */
+template <typename Geometry, typename Storage>
+size_t importCatalog(BasicInventory<Geometry, Storage>& inventory, const string& path, const CatalogOptions& options = {}) {
+    CatalogRows rows = readCatalog(path, options);
+    inventory.addItems(span(rows));
+    return rows.size();
+}
+
+#endif //CATALOGIMPORT_H
@@ -0,0 +1,193 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "Checkpoint.h"
+#include "FlatIdMap.h"
+#include "MappedFile.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// One file of a checkpoint chain, mapped and with its blocks located
+struct ChainFile {
+    unique_ptr<MappedFile> file;
+    SnapshotHeader header;
+    vector<Symbol> symbols;
+    SnapshotBlocks blocks;
+
+    explicit ChainFile(const string& path)
+        : file(make_unique<MappedFile>(path)),
+          header(SnapshotReader::readHeader(file->text())),
+          symbols(SnapshotReader::readDictionary(file->text(), header)),
+          blocks(SnapshotReader::readBlocks(file->text(), header)) {}
+};
+
+// Where the newest version of a checkout record lies
+struct RecordSource {
+    const ChainFile* source;
+    string_view record;
+};
+
+} // namespace
+
+string checkpointDeltaPath(const string& path, uint64_t generation) {
+    return path + "." + to_string(generation);
+}
+
+void removeCheckpointDeltas(const string& path, uint64_t lastGeneration) {
+    const filesystem::path base(path);
+    const filesystem::path directory = base.parent_path().empty() ? filesystem::path(".") : base.parent_path();
+    const string prefix = base.filename().string() + ".";
+
+    error_code error;
+    for (const auto& entry : filesystem::directory_iterator(directory, error)) {
+        const string name = entry.path().filename().string();
+        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) continue;
+        const string suffix = name.substr(prefix.size());
+        if (!all_of(suffix.begin(), suffix.end(), [](char c) { return c >= '0' && c <= '9'; })) continue;
+        if (suffix.size() < 20 && stoull(suffix) <= lastGeneration) {
+            filesystem::remove(entry.path(), error);
+        }
+    }
+}
+
+/**
+ * Compaction
+ *
+ * Every file of the chain is mapped, and the newest version of each shelf block
+ * and checkout record is picked out by position alone. Those are then decoded
+ * and re-encoded into the new base, because every file has its own dictionary.
+ * The new base is committed before any delta is deleted, and it carries the
+ * generation of the newest delta, so a crash in between leaves deltas the
+ * loader no longer looks for.
+ */
+uint64_t compactCheckpoints(const string& path) {
+    vector<unique_ptr<ChainFile>> chain;
+    chain.push_back(make_unique<ChainFile>(path));
+    const SnapshotHeader& base = chain.front()->header;
+    if (base.kind != SnapshotKind::Full) {
+        throw runtime_error("Checkpoint " + path + " is not a full snapshot");
+    }
+    for (uint64_t generation = base.generation + 1;; generation++) {
+        const string deltaPath = checkpointDeltaPath(path, generation);
+        if (!filesystem::exists(deltaPath)) break;
+        chain.push_back(make_unique<ChainFile>(deltaPath));
+        const SnapshotHeader& header = chain.back()->header;
+        if (header.kind != SnapshotKind::Delta || header.generation != generation ||
+            header.shelfCount != base.shelfCount || header.compartmentsPerShelf != base.compartmentsPerShelf) {
+            throw runtime_error("Checkpoint " + deltaPath + " does not follow " + path);
+        }
+    }
+
+    vector<pair<const ChainFile*, string_view>> shelves(base.shelfCount);
+    FlatIdMap<RecordSource> records;
+    ItemId nextId = 0;
+    for (const auto& file : chain) {
+        for (const auto& [shelf, block] : file->blocks.shelves) {
+            shelves[shelf] = {file.get(), block};
+        }
+        SnapshotReader in(file->blocks.checkouts, file->symbols);
+        const auto removed = in.getCount(sizeof(int32_t));
+        for (uint32_t i = 0; i < removed; i++) records.erase(in.get<int32_t>());
+        const auto count = in.getCount(sizeof(uint32_t));
+        for (uint32_t i = 0; i < count; i++) {
+            const size_t start = in.offset();
+            in.getString();
+            in.skip(3 * sizeof(int32_t));
+            const ItemId id = in.getItem([](auto&& item) { return item.getID(); });
+            records.insert_or_assign(id, {file.get(), file->blocks.checkouts.substr(start, in.offset() - start)});
+        }
+        nextId = max(nextId, file->header.nextId);
+    }
+
+    const string temporary = path + ".tmp";
+    ofstream out(temporary, ios::binary | ios::trunc);
+    if (!out) {
+        throw runtime_error("Cannot write snapshot " + temporary);
+    }
+    SnapshotHeader header{base.shelfCount, base.compartmentsPerShelf, nextId, 0,
+                          chain.back()->header.generation, SnapshotKind::Full, static_cast<uint32_t>(base.shelfCount)};
+    SnapshotWriter::writeHeader(out, header);
+
+    SnapshotWriter writer;
+    for (int shelf = 0; shelf < base.shelfCount; shelf++) {
+        const auto& [source, block] = shelves[shelf];
+        SnapshotReader in(block, source->symbols);
+        const auto count = in.getCount(sizeof(uint32_t));
+        writer.put<uint32_t>(static_cast<uint32_t>(shelf));
+        writer.put<uint32_t>(count);
+        for (uint32_t i = 0; i < count; i++) {
+            writer.put<uint32_t>(in.get<uint32_t>());
+            in.getItem([&](auto&& item) { writer.putItem(item); });
+        }
+        writer.flushBlock(out);
+    }
+
+    writer.put<uint32_t>(0);
+    writer.put<uint32_t>(static_cast<uint32_t>(records.size()));
+    for (const auto& entry : records) {
+        SnapshotReader in(entry.value.record, entry.value.source->symbols);
+        writer.putString(in.getString());
+        writer.put<int32_t>(in.get<int32_t>());
+        writer.put<int32_t>(in.get<int32_t>());
+        writer.put<int32_t>(in.get<int32_t>());
+        in.getItem([&](auto&& item) { writer.putItem(item); });
+    }
+    writer.flushBlock(out);
+
+    header.dictionaryOffset = static_cast<uint64_t>(out.tellp());
+    SnapshotWriter::writeDictionary(out, writer.symbols());
+    const uint64_t size = static_cast<uint64_t>(out.tellp());
+    out.seekp(0);
+    SnapshotWriter::writeHeader(out, header);
+    out.close();
+    if (!out) {
+        throw runtime_error("Cannot write snapshot " + temporary);
+    }
+
+    // The files must be unmapped before they can be replaced on Windows
+    chain.clear();
+    commitFile(temporary, path);
+    removeCheckpointDeltas(path, header.generation);
+    return size;
+}
+
+Checkpointer::Checkpointer(function<void()> task, chrono::milliseconds interval)
+    : task(move(task)), interval(interval), worker([this](stop_token stop) { run(stop); }) {}
+
+Checkpointer::~Checkpointer() {
+    worker.request_stop();
+}
+
+string Checkpointer::lastError() const {
+    unique_lock guard(lock);
+    return error;
+}
+
+void Checkpointer::run(stop_token stop) {
+    unique_lock guard(lock);
+    while (true) {
+        // Only a stop request ends the wait early
+        wake.wait_for(guard, stop, interval, [] { return false; });
+        if (stop.stop_requested()) return;
+
+        guard.unlock();
+        string failure;
+        try {
+            task();
+        } catch (const exception& e) {
+            failure = e.what();
+        }
+        guard.lock();
+        error = move(failure);
+    }
+}
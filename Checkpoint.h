@@ -0,0 +1,110 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "Item.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+/**
+ * Checkpoint files
+ *
+ * A checkpoint chain is a full snapshot at its base path followed by deltas at
+ * "<path>.<generation>", one per later checkpoint, with consecutive generations.
+ * Each delta holds only the shelves and checkout records that changed since the
+ * checkpoint before it. Loading applies the base and then every delta in order;
+ * compaction merges them back into a new base so the chain stays short.
+ */
+
+/**
+ * @struct CheckpointOptions
+ * @brief What Inventory::checkpoint records, and when it merges the chain into a new base snapshot
+ */
+struct CheckpointOptions {
+    double compactionRatio = 1.0; ///< Compact once the deltas add up to this fraction of the base
+    size_t maxDeltas = 16;        ///< Compact once the chain has this many deltas
+    ItemId nextId = 0;            ///< Caller's next unused item ID, returned by loadSnapshot after a restart
+};
+
+/**
+ * @struct CheckpointChain
+ * @brief What an inventory last wrote to or loaded from a checkpoint chain
+ */
+struct CheckpointChain {
+    string path;             ///< Base snapshot of the chain, or empty if there is none yet
+    uint64_t generation = 0; ///< Generation of the newest durable checkpoint
+    uint64_t baseBytes = 0;  ///< Size of the base snapshot
+    uint64_t deltaBytes = 0; ///< Combined size of the deltas after it
+    size_t deltaCount = 0;   ///< Number of deltas after it
+};
+
+/// @return Path of the delta of the given generation in the chain based at path
+string checkpointDeltaPath(const string& path, uint64_t generation);
+
+/**
+ * @brief Deletes the deltas of the chain based at path up to a generation
+ * @param path Base snapshot of the chain
+ * @param lastGeneration Newest generation to delete; by default every delta
+ */
+void removeCheckpointDeltas(const string& path, uint64_t lastGeneration = numeric_limits<uint64_t>::max());
+
+/**
+ * @brief Merges a base snapshot and its deltas into a new base snapshot
+ * @param path Base snapshot of the chain
+ * @return Size of the new base snapshot
+ * @throws runtime_error if a file of the chain is missing, corrupt or does not
+ *         match the base
+ *
+ * Works on the files alone, one shelf at a time, so it can run while the
+ * inventory keeps changing and needs memory for one shelf, not one inventory.
+ */
+uint64_t compactCheckpoints(const string& path);
+
+/**
+ * @class Checkpointer
+ * @brief Runs a checkpoint periodically on a background thread
+ *
+ * The task is typically a lambda calling Inventory::checkpoint. A failed
+ * checkpoint is retried at the next interval; the inventory keeps the changes it
+ * could not write marked as dirty, and the journal keeps their records.
+ */
+class Checkpointer {
+public:
+    /**
+     * @param task Checkpoint to run; must stay valid while the Checkpointer lives
+     * @param interval Time between the end of one checkpoint and the next
+     */
+    Checkpointer(function<void()> task, chrono::milliseconds interval);
+
+    /// Waits for a running checkpoint to finish, then stops the thread
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    /// @return Message of the last checkpoint if it failed, otherwise empty
+    string lastError() const;
+
+private:
+    function<void()> task;
+    chrono::milliseconds interval;
+    mutable mutex lock;
+    condition_variable_any wake;
+    string error;
+    jthread worker;
+
+    void run(stop_token stop);
+};
+
+#endif //CHECKPOINT_H
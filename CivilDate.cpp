@@ -0,0 +1,86 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "CivilDate.h"
+#include <atomic>
+#include <charconv>
+#include <ctime>
+
+using namespace std;
+
+static_assert(daysFromCivil(1970, 1, 1) == 0);
+static_assert(daysFromCivil(2000, 3, 1) == 11017);
+static_assert(civilFromDays(11016).month == 2 && civilFromDays(11016).day == 29);
+static_assert(civilFromDays(-1).year == 1969 && civilFromDays(-1).day == 31);
+
+namespace {
+
+constexpr int64_t secondsPerDay = 86400;
+
+/**
+ * The current day and when it ends, packed into one word so that readers never
+ * see the number of one day with the end of another: the day number in the high
+ * half, and the end as seconds after the day number's UTC midnight in the low
+ * half. Zero ends at the epoch, so the first call always looks the day up.
+ */
+atomic<uint64_t> currentDay{0};
+
+}
+
+/**
+ * Today
+ *
+ * Converting the clock to a local date means consulting the time zone rules,
+ * and localtime, the usual way, returns a static buffer shared by every thread.
+ * The day only changes at midnight, so the first call each day converts with
+ * localtime_r and asks mktime when the next local midnight falls, which also
+ * accounts for a daylight saving change in between; later calls just compare
+ * the clock against it. Two threads that both find the day over store the same
+ * result.
+ */
+int32_t today() {
+    const int64_t now = time(nullptr);
+    const uint64_t cached = currentDay.load(memory_order_relaxed);
+    const auto day = static_cast<int32_t>(cached >> 32);
+    if (now < day * secondsPerDay + static_cast<int32_t>(cached)) return day;
+
+    const time_t clock = now;
+    tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &clock);
+#else
+    localtime_r(&clock, &local);
+#endif
+    const int32_t current = daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+
+    tm midnight{};
+    midnight.tm_year = local.tm_year;
+    midnight.tm_mon = local.tm_mon;
+    midnight.tm_mday = local.tm_mday + 1;
+    midnight.tm_isdst = -1;
+    const int64_t end = mktime(&midnight);
+
+    // If mktime fails the end is before the day started, so the next call looks again
+    const auto endOffset = static_cast<int32_t>(end - current * secondsPerDay);
+    currentDay.store(static_cast<uint64_t>(static_cast<uint32_t>(current)) << 32 | static_cast<uint32_t>(endOffset),
+                     memory_order_relaxed);
+    return current;
+}
+
+string formatDate(int32_t days) {
+    const CivilDate date = civilFromDays(days);
+    char text[16];
+    char* out = text;
+    if (date.year >= 0 && date.year < 1000) {
+        // Pad to four digits
+        for (int scale = 1000; scale > 1 && date.year < scale; scale /= 10) *out++ = '0';
+    }
+    out = to_chars(out, text + sizeof(text), date.year).ptr;
+    for (const unsigned field : {date.month, date.day}) {
+        *out++ = '-';
+        *out++ = static_cast<char>('0' + field / 10);
+        *out++ = static_cast<char>('0' + field % 10);
+    }
+    return string(text, out);
+}
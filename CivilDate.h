@@ -0,0 +1,68 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef CIVILDATE_H
+#define CIVILDATE_H
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+/**
+ * Calendar dates as day numbers
+ *
+ * A date is stored as the number of days since 1970-01-01 in the proleptic
+ * Gregorian calendar, so comparing two dates or adding days to one is integer
+ * arithmetic. The conversions below use Howard Hinnant's days_from_civil and
+ * civil_from_days algorithms: a handful of integer divisions, no tables, no
+ * time zone and no allocation, and usable at compile time.
+ */
+
+/// A date split into its calendar fields
+struct CivilDate {
+    int year;
+    unsigned month; ///< 1 to 12
+    unsigned day;   ///< 1 to 31
+};
+
+/**
+ * @brief Converts a calendar date to its day number
+ * @return Days since 1970-01-01; month and day must be in range
+ */
+constexpr int32_t daysFromCivil(int year, unsigned month, unsigned day) {
+    // Count years from March, so the leap day is the last day of its year
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const auto yearOfEra = static_cast<unsigned>(year - era * 400);
+    const unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<int32_t>(dayOfEra) - 719468;
+}
+
+/// @brief Converts a day number back to its calendar date
+constexpr CivilDate civilFromDays(int32_t days) {
+    days += 719468;
+    const int era = (days >= 0 ? days : days - 146096) / 146097;
+    const auto dayOfEra = static_cast<unsigned>(days - era * 146097);
+    const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const unsigned shiftedMonth = (5 * dayOfYear + 2) / 153;
+    const unsigned day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    const unsigned month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    return {static_cast<int>(yearOfEra) + era * 400 + (month <= 2), month, day};
+}
+
+/**
+ * @brief Today's day number in local time
+ *
+ * Reads the clock on every call but consults the time zone only once a day,
+ * so it is cheap enough to call per operation. Safe to call from any thread.
+ */
+int32_t today();
+
+/// @return The day as YYYY-MM-DD
+string formatDate(int32_t days);
+
+#endif //CIVILDATE_H
@@ -0,0 +1,27 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "Crc32.h"
+#include <array>
+
+using namespace std;
+
+namespace {
+
+constexpr array<uint32_t, 256> crcTable = [] {
+    array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int bit = 0; bit < 8; bit++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[i] = c;
+    }
+    return table;
+}();
+
+} // namespace
+
+uint32_t crc32Update(uint32_t state, string_view bytes) {
+    for (const unsigned char byte : bytes) state = crcTable[(state ^ byte) & 0xFF] ^ (state >> 8);
+    return state;
+}
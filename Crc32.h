@@ -0,0 +1,25 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <cstdint>
+#include <string_view>
+
+using namespace std;
+
+/**
+ * @brief Feeds bytes into a running CRC-32 (the IEEE polynomial, as zlib uses)
+ * @param state ~0u to start, or the result of an earlier call
+ * @return The new state; the checksum is its complement
+ *
+ * Lets a checksum cover pieces that are not contiguous in memory.
+ */
+uint32_t crc32Update(uint32_t state, string_view bytes);
+
+/// @return CRC-32 of bytes
+inline uint32_t crc32(string_view bytes) { return ~crc32Update(~0u, bytes); }
+
+#endif //CRC32_H
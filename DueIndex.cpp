@@ -0,0 +1,58 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "DueIndex.h"
+
+using namespace std;
+
+/**
+ * Filing an ID
+ *
+ * The ID goes into its new bucket before anything else changes, since that and
+ * a new entry are the only steps that allocate; if either fails, the bucket is
+ * put back as it was. Only then is a renewed ID taken out of its old bucket.
+ */
+void DueIndex::add(ItemId id, int32_t day) {
+    Entry* existing = entries.find(id);
+    if (existing != nullptr && existing->day == day) return;
+
+    const auto [bucket, created] = buckets.try_emplace(day);
+    const auto index = static_cast<uint32_t>(bucket->second.size());
+    try {
+        bucket->second.push_back(id);
+        if (existing == nullptr) entries.emplace(id, Entry{day, index});
+    } catch (...) {
+        if (bucket->second.size() > index) bucket->second.pop_back();
+        if (created) buckets.erase(bucket);
+        throw;
+    }
+    if (existing != nullptr) {
+        unlink(*existing);
+        *existing = Entry{day, index};
+    }
+}
+
+void DueIndex::remove(ItemId id) {
+    if (const Entry* entry = entries.find(id)) {
+        unlink(*entry);
+        entries.erase(id);
+    }
+}
+
+void DueIndex::clear() {
+    buckets.clear();
+    entries.clear();
+}
+
+void DueIndex::unlink(const Entry& entry) noexcept {
+    const auto bucket = buckets.find(entry.day);
+    vector<ItemId>& ids = bucket->second;
+    if (entry.index + 1 != ids.size()) {
+        // Fill the hole with the bucket's last ID
+        ids[entry.index] = ids.back();
+        entries.find(ids.back())->index = entry.index;
+    }
+    ids.pop_back();
+    if (ids.empty()) buckets.erase(bucket);
+}
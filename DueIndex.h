@@ -0,0 +1,74 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef DUEINDEX_H
+#define DUEINDEX_H
+
+#include "FlatIdMap.h"
+#include "Item.h"
+#include <cstdint>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @class DueIndex
+ * @brief Checked-out item IDs ordered by the day they are due
+ *
+ * A calendar queue: the IDs due on each day share a bucket, and the buckets are
+ * kept in a map ordered by day, which only holds the days something is due on.
+ * A query over a range of days finds its first bucket in logarithmic time and
+ * then reads whole buckets, so it costs the number of items it returns rather
+ * than the number checked out. Checkouts made on the same day are all due on the
+ * same day, so new loans nearly always land in one bucket at the end.
+ *
+ * Each ID also maps to its day and where it is in that bucket, so removing it
+ * swaps the last ID of the bucket into its place instead of searching for it.
+ * Within a bucket IDs are in no particular order.
+ */
+class DueIndex {
+public:
+    /**
+     * @brief Records that the item with id is due on day, replacing the day it was due before
+     * @throws bad_alloc if the index cannot grow; it is then unchanged
+     */
+    void add(ItemId id, int32_t day);
+
+    /// @brief Forgets id; an ID that is not in the index is ignored
+    void remove(ItemId id);
+
+    /// @brief Empties the index
+    void clear();
+
+    /// @return Number of items in the index
+    size_t size() const { return entries.size(); }
+
+    /**
+     * @brief Calls f(id, day) for every item due from first to last, both included
+     *
+     * Items are visited in order of their due day. f must not change the index.
+     */
+    template <typename F>
+    void forEachDue(int32_t first, int32_t last, F&& f) const {
+        for (auto bucket = buckets.lower_bound(first); bucket != buckets.end() && bucket->first <= last; ++bucket) {
+            for (const ItemId id : bucket->second) f(id, bucket->first);
+        }
+    }
+
+private:
+    /// Where an ID is filed
+    struct Entry {
+        int32_t day;
+        uint32_t index; ///< Position in the bucket of day
+    };
+
+    map<int32_t, vector<ItemId>> buckets; ///< Never holds an empty bucket
+    FlatIdMap<Entry> entries;
+
+    /// @brief Takes the ID filed under entry out of its bucket
+    void unlink(const Entry& entry) noexcept;
+};
+
+#endif //DUEINDEX_H
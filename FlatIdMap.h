@@ -0,0 +1,216 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef FLATIDMAP_H
+#define FLATIDMAP_H
+
+#include "Item.h"
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @class FlatIdMap
+ * @brief Open-addressing hash table keyed by ItemId with contiguous value storage
+ *
+ * Entries live densely packed in one vector, so walking every value is a linear
+ * sweep over memory. A separate power-of-two slot table maps an ID to its entry
+ * through linear probing; erasing uses backward-shift deletion, so the table never
+ * accumulates tombstones. Removing an entry moves the last entry into the hole,
+ * which means iteration order is not stable across erasures and pointers returned
+ * by find() are only valid until the next insertion or erasure.
+ */
+template <typename Value>
+class FlatIdMap {
+public:
+    struct Entry {
+        ItemId key;
+        Value value;
+    };
+
+    using iterator = typename vector<Entry>::iterator;
+    using const_iterator = typename vector<Entry>::const_iterator;
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    /**
+     * @brief Makes room for count entries without further rehashing
+     *
+     * The entries grow at least geometrically, so callers that reserve a few
+     * more entries before each small batch still copy each entry O(1) times.
+     */
+    void reserve(size_t count) {
+        if (count > entries.capacity()) entries.reserve(max(count, entries.capacity() * 2));
+        size_t wanted = minimumCapacity;
+        while (wanted * maxLoadNumerator < count * maxLoadDenominator) wanted *= 2;
+        if (wanted > slots.size()) rehash(wanted);
+    }
+
+    void clear() {
+        entries.clear();
+        slots.assign(slots.size(), emptySlot);
+    }
+
+    /**
+     * @brief Finds the value stored for key
+     * @return Pointer to the value, or nullptr if the key is absent
+     */
+    Value* find(ItemId key) {
+        const size_t slot = findSlot(key);
+        return slot == notFound ? nullptr : &entries[slots[slot]].value;
+    }
+
+    const Value* find(ItemId key) const {
+        const size_t slot = findSlot(key);
+        return slot == notFound ? nullptr : &entries[slots[slot]].value;
+    }
+
+    bool contains(ItemId key) const { return findSlot(key) != notFound; }
+
+    /**
+     * @brief Inserts value under key unless the key is already present
+     * @return Pointer to the stored value and whether an insertion happened
+     */
+    pair<Value*, bool> emplace(ItemId key, Value value) {
+        if (const size_t slot = findSlot(key); slot != notFound) {
+            return {&entries[slots[slot]].value, false};
+        }
+        if ((entries.size() + 1) * maxLoadDenominator > slots.size() * maxLoadNumerator) {
+            rehash(slots.empty() ? minimumCapacity : slots.size() * 2);
+        }
+        const auto index = static_cast<int32_t>(entries.size());
+        entries.push_back(Entry{key, move(value)});
+        slots[probeForInsert(key)] = index;
+        return {&entries.back().value, true};
+    }
+
+    /**
+     * @brief Inserts or overwrites the value stored under key
+     */
+    void insert_or_assign(ItemId key, Value value) {
+        if (Value* existing = find(key)) {
+            *existing = move(value);
+        } else {
+            emplace(key, move(value));
+        }
+    }
+
+    /**
+     * @brief Removes key and hands back its value
+     * @return The removed value, or nullopt if the key was absent
+     */
+    optional<Value> extract(ItemId key) {
+        const size_t slot = findSlot(key);
+        if (slot == notFound) return nullopt;
+        optional<Value> out(move(entries[slots[slot]].value));
+        eraseSlot(slot);
+        return out;
+    }
+
+    /**
+     * @brief Removes key if present
+     * @return true if the key was present
+     */
+    bool erase(ItemId key) {
+        const size_t slot = findSlot(key);
+        if (slot == notFound) return false;
+        eraseSlot(slot);
+        return true;
+    }
+
+    /**
+     * @brief Removes every entry for which pred(entry) is true
+     * @return Number of entries removed
+     *
+     * Removes many keys in one pass: the survivors are packed in place, keeping
+     * their relative order, and the slot table is rebuilt once at the end rather
+     * than repaired after every single removal.
+     */
+    template <typename Pred>
+    size_t erase_if(Pred pred) {
+        const size_t before = entries.size();
+        std::erase_if(entries, [&](const Entry& entry) { return pred(entry); });
+        const size_t removed = before - entries.size();
+        if (removed != 0) rehash(slots.size());
+        return removed;
+    }
+
+private:
+    static constexpr int32_t emptySlot = -1;
+    static constexpr size_t notFound = static_cast<size_t>(-1);
+    static constexpr size_t minimumCapacity = 16;
+    // Linear probing stays short below roughly three-quarters occupancy
+    static constexpr size_t maxLoadNumerator = 3;
+    static constexpr size_t maxLoadDenominator = 4;
+
+    vector<Entry> entries;
+    vector<int32_t> slots;
+
+    size_t mask() const { return slots.size() - 1; }
+
+    // Fibonacci hashing spreads the sequential IDs handed out by the front desk
+    size_t home(ItemId key) const {
+        return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(key)) * 0x9E3779B97F4A7C15ull) >> 32) & mask();
+    }
+
+    size_t findSlot(ItemId key) const {
+        if (slots.empty()) return notFound;
+        for (size_t slot = home(key);; slot = (slot + 1) & mask()) {
+            const int32_t index = slots[slot];
+            if (index == emptySlot) return notFound;
+            if (entries[index].key == key) return slot;
+        }
+    }
+
+    size_t probeForInsert(ItemId key) const {
+        size_t slot = home(key);
+        while (slots[slot] != emptySlot) slot = (slot + 1) & mask();
+        return slot;
+    }
+
+    void rehash(size_t capacity) {
+        slots.assign(capacity, emptySlot);
+        for (size_t i = 0; i < entries.size(); i++) {
+            slots[probeForInsert(entries[i].key)] = static_cast<int32_t>(i);
+        }
+    }
+
+    void eraseSlot(size_t slot) {
+        const int32_t index = slots[slot];
+
+        // Backward-shift the probe chain so lookups never need tombstones
+        size_t hole = slot;
+        for (size_t next = (hole + 1) & mask(); slots[next] != emptySlot; next = (next + 1) & mask()) {
+            const size_t ideal = home(entries[slots[next]].key);
+            // Move the entry back only if the hole lies on its probe path
+            if (((next - ideal) & mask()) >= ((next - hole) & mask())) {
+                slots[hole] = slots[next];
+                hole = next;
+            }
+        }
+        slots[hole] = emptySlot;
+
+        // Keep the dense array packed by moving the last entry into the gap
+        const auto last = static_cast<int32_t>(entries.size() - 1);
+        if (index != last) {
+            entries[index] = move(entries[last]);
+            size_t moved = home(entries[index].key);
+            while (slots[moved] != last) moved = (moved + 1) & mask();
+            slots[moved] = index;
+        }
+        entries.pop_back();
+    }
+};
+
+#endif //FLATIDMAP_H
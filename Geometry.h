@@ -0,0 +1,123 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include "Position.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @class DynamicGeometry
+ * @brief Shelf layout chosen at run time
+ *
+ * Used by branches whose size is only known when the program starts. The
+ * dimensions are validated once here, so the inventory can trust them for every
+ * later bound check. Storage is a heap-allocated vector sized at construction.
+ */
+class DynamicGeometry {
+private:
+    int shelves;
+    int compartments;
+
+public:
+    /// Shelf count used when no geometry is given
+    static constexpr int defaultShelfCount = 3;
+
+    /// Compartments per shelf used when no geometry is given
+    static constexpr int defaultCompartmentsPerShelf = 15;
+
+    template <typename T>
+    using Array = vector<T>;
+
+    /// One bit per compartment, each shelf padded to whole 64-bit words
+    using OccupancyStorage = vector<uint64_t>;
+
+    explicit DynamicGeometry(int shelfCount = defaultShelfCount, int compartmentsPerShelf = defaultCompartmentsPerShelf)
+        : shelves(shelfCount), compartments(compartmentsPerShelf) {
+        if (shelfCount <= 0 || compartmentsPerShelf <= 0) {
+            throw invalid_argument("Shelf and compartment counts must be positive");
+        }
+        // Checkout records keep a compartment's index in 32 bits
+        if (size() > numeric_limits<uint32_t>::max()) {
+            throw invalid_argument("Too many compartments");
+        }
+    }
+
+    constexpr int shelfCount() const { return shelves; }
+    constexpr int compartmentsPerShelf() const { return compartments; }
+    constexpr size_t size() const { return static_cast<size_t>(shelves) * compartments; }
+
+    constexpr bool isValid(const Position& pos) const { return pos.isValid(shelves, compartments); }
+
+    // Row-major: compartment c of shelf s lives at s * compartments + c
+    constexpr size_t indexOf(const Position& pos) const {
+        return static_cast<size_t>(pos.getRow()) * compartments + pos.getCol();
+    }
+
+    /// @return The position whose indexOf is index
+    constexpr Position positionOf(size_t index) const {
+        return Position(static_cast<int>(index / compartments), static_cast<int>(index % compartments));
+    }
+
+    constexpr int wordsPerShelf() const { return (compartments + 63) / 64; }
+
+    template <typename T>
+    Array<T> makeArray(size_t count) const { return Array<T>(count); }
+
+    OccupancyStorage makeOccupancyStorage() const {
+        return OccupancyStorage(static_cast<size_t>(shelves) * wordsPerShelf());
+    }
+};
+
+/**
+ * @class FixedGeometry
+ * @brief Shelf layout fixed at compile time
+ *
+ * Used for kiosks whose layout never changes. Every dimension, bound check and
+ * index computation is constexpr, so the compiler can fold the checks and unroll
+ * full-inventory scans. Storage is a std::array embedded in the inventory itself.
+ */
+template <int Shelves, int Compartments>
+class FixedGeometry {
+    static_assert(Shelves > 0 && Compartments > 0, "Shelf and compartment counts must be positive");
+    static_assert(static_cast<size_t>(Shelves) * Compartments <= numeric_limits<uint32_t>::max(),
+                  "Checkout records keep a compartment's index in 32 bits");
+
+public:
+    template <typename T>
+    using Array = array<T, static_cast<size_t>(Shelves) * Compartments>;
+
+    using OccupancyStorage = array<uint64_t, static_cast<size_t>(Shelves) * ((Compartments + 63) / 64)>;
+
+    static constexpr int shelfCount() { return Shelves; }
+    static constexpr int compartmentsPerShelf() { return Compartments; }
+    static constexpr size_t size() { return static_cast<size_t>(Shelves) * Compartments; }
+
+    static constexpr bool isValid(const Position& pos) { return pos.isValid(Shelves, Compartments); }
+
+    static constexpr size_t indexOf(const Position& pos) {
+        return static_cast<size_t>(pos.getRow()) * Compartments + pos.getCol();
+    }
+
+    static constexpr Position positionOf(size_t index) {
+        return Position(static_cast<int>(index / Compartments), static_cast<int>(index % Compartments));
+    }
+
+    static constexpr int wordsPerShelf() { return (Compartments + 63) / 64; }
+
+    template <typename T>
+    static constexpr Array<T> makeArray(size_t) { return Array<T>{}; }
+
+    static constexpr OccupancyStorage makeOccupancyStorage() { return OccupancyStorage{}; }
+};
+
+#endif //GEOMETRY_H
@@ -5,68 +5,302 @@
 #ifndef INVENTORY_H
 #define INVENTORY_H
 
+#include "CatalogColumns.h"
+#include "Checkpoint.h"
+#include "CivilDate.h"
+#include "DueIndex.h"
+#include "FlatIdMap.h"
+#include "Geometry.h"
 #include "Item.h"
+#include "ItemIndex.h"
+#include "ItemStorage.h"
+#include "Journal.h"
+#include "PatronRegistry.h"
 #include "Position.h"
-#include <map>
+#include "TextIndex.h"
+#include "TimerWheel.h"
+#include <concepts>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
 /**
- * @struct CheckoutInfo
+ * @struct BasicCheckoutInfo
  * @brief Structure to store information about checked out items
+ * @tparam Loan How the inventory's storage policy holds a checked-out item
  * 
  * This structure maintains all necessary information about a checked out item,
  * including who checked it out, when it's due, where it belongs, and the item itself.
  * I chose to use a struct here since this is primarily a data container with no complex
  * behaviors, making the fields directly accessible to the Inventory class.
+ *
+ * Every open loan has one, so the fields are packed: the home compartment is
+ * its 32-bit index in the shelf array rather than a Position, and under
+ * PooledStorage the item is a one-word handle, which makes the record 24 bytes.
  */
-struct CheckoutInfo {
-    string checkedOutBy;      ///< Name of the person who checked out the item
-    string dueDate;           ///< Due date for returning the item
-    Position originalPosition; ///< Original shelf and compartment position
-    unique_ptr<Item> item;    ///< Smart pointer to the actual item
+template <typename Loan>
+struct BasicCheckoutInfo {
+    Loan item;                ///< The item itself, moved out of its compartment
+    PatronId patron;          ///< Patron who checked out the item
+    int32_t dueDay;           ///< Due date for returning the item, as days since 1970-01-01
+    uint32_t home;            ///< Index of the compartment the item came from
+    TimerHandle timer = noTimer; ///< Pending reminder or overdue timer of the loan, or noTimer once both have fired
     
     /**
-     * @brief Constructor for CheckoutInfo
-     * @param by Person who checked out the item
-     * @param due Due date for returning the item
-     * @param pos Original position of the item
-     * @param i Smart pointer to the item
+     * @brief Constructor for BasicCheckoutInfo
+     * @param by Patron who checked out the item
+     * @param due Day number of the due date
+     * @param compartment Index of the item's original compartment
+     * @param i The item, as lent by the storage policy
      * 
-     * Using smart pointers (unique_ptr) here ensures that memory is properly managed
-     * and that the Item object is automatically deleted when the CheckoutInfo is destroyed.
+     * The storage policy lends the item without copying it (a pooled pointer
+     * or an inline value), so memory is managed automatically and checkin can
+     * move it straight back into its compartment.
      */
-    CheckoutInfo(string by, string due, Position pos, unique_ptr<Item> i)
-        : checkedOutBy(by), dueDate(due), originalPosition(pos), item(move(i)) {}
+    BasicCheckoutInfo(PatronId by, int32_t due, uint32_t compartment, Loan i)
+        : item(move(i)), patron(by), dueDay(due), home(compartment) {}
+};
+
+/// Checkout record of the default, pooled inventory
+using CheckoutInfo = BasicCheckoutInfo<PooledStorage::Loan>;
+
+static_assert(sizeof(CheckoutInfo) == 24, "Checkout records are packed for large loan counts");
+
+/**
+ * @struct CheckinReport
+ * @brief Outcome of Inventory::checkinItems
+ */
+struct CheckinReport {
+    size_t returned = 0;               ///< Number of items put back on their shelves
+    vector<ItemId> notCheckedOut;      ///< Requested IDs that had no checkout record
+    vector<ItemId> compartmentOccupied; ///< IDs left checked out because their compartment was taken
+};
+
+/// Outcome of checking out one item in a batch
+enum class CheckoutStatus {
+    CheckedOut,        ///< The item was on a shelf and is now checked out
+    AlreadyCheckedOut, ///< The item was already checked out, possibly earlier in the same batch
+    NotFound,          ///< No item with this ID exists
+    LimitReached       ///< The patron already had as many items out as their loan limit allows
+};
+
+/**
+ * @struct CheckoutResult
+ * @brief Per-item result of Inventory::checkoutItems
+ */
+struct CheckoutResult {
+    ItemId id;             ///< ID that was requested
+    CheckoutStatus status; ///< What happened to it
+    Item* item;            ///< The checked-out item, or nullptr unless status is CheckedOut
+};
+
+/**
+ * @struct ItemLocation
+ * @brief Where an item found by a secondary index is
+ */
+struct ItemLocation {
+    ItemId id;          ///< ID of the item
+    Position position;  ///< Its compartment, or the compartment it returns to if checked out
+    bool checkedOut;    ///< Whether the item is checked out
+};
+
+/**
+ * @struct SearchHit
+ * @brief An item found by a keyword search, and how well it matched
+ */
+struct SearchHit {
+    ItemLocation location; ///< Where the item is
+    uint32_t score;        ///< Number of times the query words occur in its text
+};
+
+/**
+ * @struct DueLoan
+ * @brief A checked-out item found by its due date
+ */
+struct DueLoan {
+    ItemId id;                 ///< ID of the item
+    int32_t dueDay;            ///< Due date, as days since 1970-01-01
+    PatronId patron;           ///< Patron who checked out the item
+    Position originalPosition; ///< Compartment the item returns to
+};
+
+/// What a LoanEvent reports
+enum class LoanEventKind : uint8_t {
+    DueSoon, ///< The loan falls due within the reminder lead
+    Overdue  ///< The loan's due date has passed
 };
 
 /**
- * @class Inventory
+ * @struct LoanEvent
+ * @brief A due-date reminder or overdue notice, as returned by pollLoanEvents
+ */
+struct LoanEvent {
+    ItemId id;                 ///< ID of the checked-out item
+    LoanEventKind kind;        ///< Which event fired
+    int32_t dueDay;            ///< Due date, as days since 1970-01-01
+    PatronId patron;           ///< Patron who checked out the item
+};
+
+template <typename Geometry, typename Storage = PooledStorage>
+class BasicInventory;
+
+template <typename Geometry, typename Storage>
+ostream& operator<<(ostream& os, const BasicInventory<Geometry, Storage>& inventory);
+
+/**
+ * @class BasicInventory
  * @brief Manages the library inventory system
+ * @tparam Geometry Shelf layout policy, either DynamicGeometry or FixedGeometry
+ * @tparam Storage Item storage policy, either PooledStorage or InlineStorage
  * 
  * This class represents the entire library inventory system, handling storage
  * of items across shelves and compartments, checkout/checkin operations,
  * and various utility functions. I designed this class to model the physical
  * arrangement of items in a library while providing robust functionality for
  * item management.
+ *
+ * The shelf layout is a policy so that one implementation serves both the
+ * runtime-sized Inventory and the compile-time FixedInventory used by kiosks.
+ * The storage policy decides what a compartment holds: a pointer to a pooled,
+ * polymorphic item, or the item value itself for scan-heavy workloads.
  */
-class Inventory {
+template <typename Geometry, typename Storage>
+class BasicInventory {
+public:
+    /// What one compartment holds under the storage policy
+    using Slot = typename Storage::Slot;
+
+    /// Record kept for each checked-out item
+    using CheckoutRecord = BasicCheckoutInfo<typename Storage::Loan>;
+
 private:
+    /// Shelf layout: dimensions, bound checks and row-major index arithmetic
+    [[no_unique_address]] Geometry geometry;
+
+    /**
+     * Storage policy state, such as the slab allocator backing pooled items.
+     * It is declared before the shelves and checkout records so that it is
+     * destroyed after them: the items are destroyed first, then any slabs are
+     * released in bulk.
+     */
+    [[no_unique_address]] Storage storage;
+
     /**
-     * 2D array representing shelves and compartments in the library.
-     * The first dimension (3) represents the shelves, and the second dimension (15)
-     * represents compartments on each shelf. I used unique_ptr for memory safety
-     * and to support polymorphic items (Books, Movies, Magazines).
+     * Compartments of every shelf stored row-major in one contiguous allocation:
+     * compartment c of shelf s lives at index s * compartmentsPerShelf + c.
+     * With PooledStorage each compartment is a unique_ptr (with a deleter returning
+     * memory to the pool) for memory safety and to support polymorphic items
+     * (Books, Movies, Magazines); with InlineStorage it holds the item itself.
      */
-    unique_ptr<Item> shelves[3][15];
+    typename Geometry::template Array<Slot> shelves;
+
+    /**
+     * Occupancy bitmap with one bit per compartment, set when the compartment
+     * holds an item. Each shelf occupies wordsPerShelf() consecutive 64-bit words;
+     * the unused high bits of a shelf's last word are permanently set so they never
+     * look free. Scanning whole words lets findFreeCompartment skip 64 occupied
+     * compartments at a time.
+     */
+    typename Geometry::OccupancyStorage occupancy;
     
     /**
-     * Map to track checked-out items, using item ID as the key.
-     * I chose a map data structure for efficient lookup by item ID, which is
-     * critical for the checkout/checkin operations.
+     * Table to track checked-out items, using the integer item ID as the key.
+     * FlatIdMap keeps the CheckoutInfo records in one contiguous array behind an
+     * open-addressing index, so checkout and checkin are O(1) without a node
+     * allocation or a string comparison per operation.
+     */
+    FlatIdMap<CheckoutRecord> checkedOutItems;
+
+    /**
+     * Index from item ID to the compartment currently holding that item.
+     * Only items that are on a shelf are indexed; checked-out items leave the
+     * index and come back on checkin. This turns the lookup in checkoutItem
+     * into a single hash probe instead of a scan of every compartment.
+     */
+    FlatIdMap<Position> itemPositions;
+
+    /**
+     * Secondary indexes from author, director, actor, title and copyright year
+     * to item IDs, covering shelved and checked-out items alike. They hold IDs
+     * rather than positions, so only adding an item updates them; swaps,
+     * checkouts and checkins move an item without changing its ID, and the
+     * lookups resolve each ID through itemPositions and checkedOutItems.
+     */
+    ItemIndex itemIndex;
+
+    /**
+     * Full-text index over item names, descriptions and titles. Like itemIndex
+     * it holds IDs, so it is only updated when an item is added. Its searches
+     * tidy the posting lists they read, which stateLock keeps from overlapping.
      */
-    map<string, CheckoutInfo> checkedOutItems;
+    TextIndex textIndex;
+
+    /**
+     * Checked-out item IDs ordered by due date, kept in step with
+     * checkedOutItems by checkout, checkin and renewal so overdue queries do
+     * not have to scan every checkout record.
+     */
+    DueIndex dueIndex;
+
+    /**
+     * Everyone who has borrowed an item, with the items each has out. Checkout
+     * records refer to their patron by ID; checkout, checkin and snapshot
+     * loading keep each patron's loans in step with checkedOutItems.
+     */
+    PatronRegistry patrons;
+
+    /// What a loan timer fires for
+    struct LoanTimer {
+        ItemId id = 0;
+        LoanEventKind kind = LoanEventKind::DueSoon;
+    };
+
+    /**
+     * One timer per open loan, in days: first its DueSoon reminder, then, once
+     * that has fired, its Overdue notice. The handle is kept in the checkout
+     * record, so checkin and renewal cancel it without a search, and
+     * pollLoanEvents only touches the loans whose timers expire.
+     */
+    TimerWheel<LoanTimer> loanTimers{today()};
+
+    /// Days before its due date that a loan's DueSoon reminder fires
+    int reminderLead = 3;
+
+    /**
+     * Journal that every successful change is logged to, or nullptr. It is
+     * owned by the caller, which decides where it lives and how durable it is.
+     */
+    Journal* journal = nullptr;
+
+    /**
+     * Shelves changed since the last checkpoint, one bit per shelf, and the IDs
+     * whose checkout record was created or removed since then. The mutators set
+     * them as a side effect of each change; checkpoint() writes exactly these
+     * shelves and records to a delta and clears them.
+     */
+    vector<uint64_t> dirtyShelves;
+    FlatIdMap<bool> dirtyCheckouts;
+
+    /// The checkpoint chain on disk, and the generation later changes belong to
+    CheckpointChain checkpoints;
+    uint64_t liveGeneration = 0;
+
+    /**
+     * Held by every public mutator and by checkpoint() while it captures the
+     * dirty shelves, so a background checkpoint sees each change entirely or not
+     * at all. It is recursive because mutators such as addItemAnywhere are built
+     * on other public mutators. checkpointLock keeps checkpoints and snapshot
+     * saves and loads from overlapping, and is always taken first. Readers take
+     * stateLock too, so printing or saving never sees a change half made.
+     */
+    mutable recursive_mutex stateLock;
+    mutable mutex checkpointLock;
     
     /**
      * @brief Helper method to convert integer ID to string ID
@@ -78,20 +312,156 @@ private:
      */
     static string getStringId(int id) ;
 
+    /**
+     * @brief Helper method to convert a string ID back to an integer ID
+     * @param itemId String representation of the ID
+     * @param id Receives the parsed ID on success
+     * @return true if itemId is a complete, in-range integer
+     *
+     * The public API still accepts string IDs; they are parsed once here so the
+     * rest of the lookup path works on integers.
+     */
+    static bool parseItemId(const string& itemId, ItemId& id);
+
+    /**
+     * @brief Marks the padding bits past the last compartment of each shelf as occupied
+     * @param layout Geometry the bitmap belongs to
+     * @param bits Occupancy bitmap to update
+     */
+    static void markPadding(const Geometry& layout, typename Geometry::OccupancyStorage& bits);
+
+    /**
+     * @brief Maps a position to its slot in the row-major shelves array
+     * @param pos Position to map; must already be validated
+     * @return Reference to the compartment at pos
+     */
+    Slot& compartmentAt(const Position& pos);
+    const Slot& compartmentAt(const Position& pos) const;
+
+    /**
+     * @brief Records whether the compartment at pos holds an item
+     * @param pos Position to update; must already be validated
+     * @param occupied New occupancy state
+     */
+    void setOccupied(const Position& pos, bool occupied);
+
+    /**
+     * @brief Verifies that an item may be placed at position
+     * @throws out_of_range if position is invalid
+     * @throws runtime_error if the compartment is not empty
+     */
+    void checkPlacement(const Position& position) const;
+
+    /**
+     * @brief Verifies that no shelved or checked-out item already uses id
+     * @throws runtime_error if the ID is in use
+     */
+    void checkNewId(ItemId id) const;
+
+    /**
+     * @brief Updates the ID and search indexes and the occupancy bitmap for a newly stored item
+     * @param unstore Called with the compartment's slot before it is emptied on failure,
+     *        so the caller can take its item back
+     * @throws bad_alloc if an index cannot grow; the compartment is then emptied again
+     */
+    template <typename Unstore>
+    void recordPlacement(const Position& position, ItemId id, Unstore unstore);
+
+    /// @brief Marks the shelf holding pos as changed since the last checkpoint
+    void markDirty(const Position& pos);
+
+    /// @brief Marks the checkout record of id as created or removed since the last checkpoint
+    void markCheckoutDirty(ItemId id);
+
+    /// @brief Encodes one shelf block: shelf index, item count, then (compartment, item)
+    void encodeShelf(SnapshotWriter& writer, int shelf) const;
+
+    /// @brief Encodes one checkout record
+    void encodeCheckout(SnapshotWriter& writer, const CheckoutRecord& info) const;
+
+    /**
+     * @brief Generates the due date for an item checked out now
+     * @return Day number of the date 30 days from today
+     */
+    static int32_t makeDueDay();
+
+    /**
+     * @brief Moves the item at pos into the checkout table
+     * @param id ID of the item at pos
+     * @param pos Position of a shelved item
+     * @param patron Patron checking out the item
+     * @param dueDay Day number of the due date
+     * @return Pointer to the checked-out item
+     */
+    Item* moveToCheckout(ItemId id, const Position& pos, PatronId patron, int32_t dueDay);
+
+    /**
+     * @brief Changes the due date of a checked-out item
+     * @throws runtime_error if the item is not checked out
+     */
+    void extendLoan(ItemId id, int32_t dueDay);
+
+    /// @brief Schedules the next event of a loan due on dueDay in timers
+    TimerHandle scheduleLoanTimer(TimerWheel<LoanTimer>& timers, ItemId id, int32_t dueDay) const;
+
+    /// @throws out_of_range if patron is not registered
+    void checkPatron(PatronId patron) const;
+
+    /// @brief Prints one checkout record for printCheckedOutItems
+    void printCheckout(ItemId id, const CheckoutRecord& info) const;
+
+    /**
+     * @brief Shared implementation of the addItems overloads
+     * @param items Batch to insert
+     * @param itemOf Returns a const Item* for a batch entry (null if absent)
+     * @param store Moves a batch entry into an empty slot
+     * @param unstore Moves a slot's item back into its batch entry
+     */
+    template <typename Entry, typename ItemOf, typename Store, typename Unstore>
+    void insertBatch(span<Entry> items, ItemOf itemOf, Store store, Unstore unstore);
+
+    /**
+     * @brief Resolves the IDs from a secondary index to locations
+     * @param ids Posting list to resolve
+     * @param keep Called with each item; the item is returned only if it returns true
+     */
+    template <typename Keep>
+    vector<ItemLocation> locate(span<const ItemId> ids, Keep keep) const;
+
 public:
     /**
-     * @brief Default constructor
+     * @brief Constructor
+     * @param args Arguments forwarded to the Geometry; for Inventory these are
+     *             the number of shelves and the number of compartments per shelf
+     * @throws invalid_argument if either dimension is not positive
      * 
      * Initializes all compartments to empty (nullptr).
      */
-    Inventory();
+    template <typename... Args>
+        requires constructible_from<Geometry, Args...>
+    explicit BasicInventory(Args&&... args);
     
     /**
      * @brief Destructor
      * 
-     * Smart pointers handle memory cleanup automatically.
+     * Checked-out items are handed back through the storage policy, so pooled
+     * ones are destroyed in their pool; smart pointers release the rest, and the
+     * item pool then releases its slabs in bulk.
      */
-    ~Inventory();
+    ~BasicInventory();
+
+    /// @return Number of shelves in the library
+    constexpr int getShelfCount() const { return geometry.shelfCount(); }
+
+    /// @return Number of compartments on each shelf
+    constexpr int getCompartmentsPerShelf() const { return geometry.compartmentsPerShelf(); }
+
+    /**
+     * @brief Checks a position against this library's geometry
+     * @param pos Position to check
+     * @return true if pos names an existing compartment
+     */
+    bool isValidPosition(const Position& pos) const;
     
     /**
      * @brief Overloaded [] operator for accessing shelves
@@ -100,9 +470,11 @@ public:
      * @throws out_of_range if shelfIndex is invalid
      * 
      * This operator overloading enables intuitive access to items using the
-     * syntax: inventory[shelf][compartment]
+     * syntax: inventory[shelf][compartment]. Storing or releasing items through
+     * the returned pointer bypasses the ID index and occupancy bitmap; use
+     * addItem, checkoutItem and swapItems to change what a compartment holds.
      */
-    unique_ptr<Item>* operator[](int shelfIndex);
+    Slot* operator[](int shelfIndex);
     
     /**
      * @brief Const version of [] operator for read-only access
@@ -112,31 +484,159 @@ public:
      * 
      * Provides const-correct access to the storage system.
      */
-    const unique_ptr<Item>* operator[](int shelfIndex) const;
+    const Slot* operator[](int shelfIndex) const;
     
     /**
      * @brief Adds an item to the inventory at a specific position
      * @param position Shelf and compartment position
      * @param item The item to add
      * @throws out_of_range if position is invalid
-     * @throws runtime_error if compartment is not empty
+     * @throws runtime_error if compartment is not empty or the item ID is already in use
+     * @throws invalid_argument if the storage policy cannot hold the item's type
      * 
-     * Creates a copy of the item and stores it at the specified position.
-     * Uses dynamic_cast to preserve the specific item type (Book, Movie, Magazine).
+     * Creates a copy of the item in storage and stores it at the specified position.
+     * The copy has the same dynamic type as item (Book, Movie, Magazine), so no
+     * type-specific details are lost.
      */
     void addItem(const Position& position, const Item& item);
+
+    /**
+     * @brief Adds an item to the inventory, moving from it instead of copying
+     * @param position Shelf and compartment position
+     * @param item The item to add; left in a moved-from state on success
+     * @throws out_of_range if position is invalid
+     * @throws runtime_error if compartment is not empty or the item ID is already in use
+     * @throws invalid_argument if the storage policy cannot hold the item's type
+     * 
+     * Checks are made before anything is moved, and if storing fails afterwards
+     * the contents are moved back, so item keeps its contents on failure.
+     */
+    void addItem(const Position& position, Item&& item);
+
+    /**
+     * @brief Adds a heap-allocated item to the inventory, taking ownership
+     * @param position Shelf and compartment position
+     * @param item The item to add
+     * @throws out_of_range if position is invalid
+     * @throws runtime_error if compartment is not empty or the item ID is already in use
+     * @throws invalid_argument if item is null or the storage policy cannot hold its type
+     * 
+     * With PooledStorage the object itself is stored; nothing is copied or moved.
+     */
+    void addItem(const Position& position, unique_ptr<Item> item);
+
+    /**
+     * @brief Constructs an item directly in a compartment
+     * @tparam T Item type to construct; any Item subclass with PooledStorage, only
+     *         Book, Magazine or Movie with InlineStorage
+     * @param position Shelf and compartment position
+     * @param args Arguments forwarded to T's constructor
+     * @return Reference to the new item
+     * @throws out_of_range if position is invalid
+     * @throws runtime_error if compartment is not empty or the item ID is already in use
+     * 
+     * The item is built in its final storage, so no temporary is created and no
+     * string is copied beyond what T's constructor itself does.
+     */
+    template <typename T, typename... Args>
+        requires (Storage::template holds<T>)
+    T& emplaceItem(const Position& position, Args&&... args);
+
+    /**
+     * @brief Adds a batch of heap-allocated items, taking ownership of all of them
+     * @param items Target positions paired with the items to store there
+     * @throws out_of_range if any position is invalid
+     * @throws runtime_error if any compartment is not empty, two entries target the
+     *         same compartment, or any item ID is already in use or repeated in the batch
+     * @throws invalid_argument if any item is null or cannot be held by the storage policy
+     * 
+     * The whole batch is validated before anything is stored, so on error the
+     * inventory and the batch are left unchanged. Items are stored in compartment
+     * order and the ID index is grown once for the whole batch.
+     */
+    void addItems(span<pair<Position, unique_ptr<Item>>> items);
+
+    /**
+     * @brief Adds a batch of items of one concrete type, moving from them
+     * @param items Target positions paired with the items to store there
+     * @throws out_of_range, runtime_error as for the unique_ptr overload
+     * 
+     * All-or-nothing like the unique_ptr overload: if storing fails part-way
+     * (for example, when allocation fails) the items already stored are moved
+     * back into the batch.
+     */
+    template <derived_from<Item> T>
+        requires (Storage::template holds<T>)
+    void addItems(span<pair<Position, T>> items);
+
+    /**
+     * @brief Adds a batch of books, magazines and movies held by value, moving from them
+     * @param items Target positions paired with the items to store there
+     * @throws out_of_range, runtime_error as for the unique_ptr overload
+     * 
+     * Each item is constructed in storage by its concrete type, so with
+     * PooledStorage it is placed in the pool's slabs. All-or-nothing like the
+     * other overloads.
+     */
+    void addItems(span<pair<Position, ItemValue>> items);
+
+    /**
+     * @brief Finds the first empty compartment
+     * @return Position of the first empty compartment in shelf-major order, or
+     *         nullopt if every compartment is occupied
+     * 
+     * Scans the occupancy bitmap a word at a time, so the cost is proportional to
+     * compartments / 64 rather than to the number of compartments.
+     */
+    optional<Position> findFreeCompartment() const;
+
+    /**
+     * @brief Adds an item to the first empty compartment
+     * @param item The item to add
+     * @return Position the item was stored at
+     * @throws runtime_error if every compartment is occupied or the item ID is already in use
+     */
+    Position addItemAnywhere(const Item& item);
+
+    /**
+     * @brief Adds an item to the first empty compartment, moving from it
+     * @param item The item to add; left in a moved-from state on success
+     * @return Position the item was stored at
+     * @throws runtime_error if every compartment is occupied or the item ID is already in use
+     */
+    Position addItemAnywhere(Item&& item);
     
     /**
      * @brief Checks out an item from the inventory
      * @param itemId ID of the item to check out
-     * @param checkOutBy Name of the person checking out the item
+     * @param patron Patron checking out the item
      * @return Pointer to the checked-out item
-     * @throws runtime_error if item is not found
+     * @throws runtime_error if item is not found or the patron is at their loan limit
+     * @throws out_of_range if patron is not registered
      * 
-     * Moves the item from the shelf to the checkedOutItems map and
+     * Moves the item from the shelf to the checkedOutItems table and
      * records checkout information including the due date.
      */
+    Item* checkoutItem(const string& itemId, PatronId patron);
+
+    /// @brief Checks out an item to the patron called checkOutBy, registering them if they are new and the checkout goes ahead
     Item* checkoutItem(const string& itemId, const string& checkOutBy);
+
+    /**
+     * @brief Checks out several items to the same patron in one pass
+     * @param itemIds IDs of the items to check out
+     * @param patron Patron checking out the items
+     * @return One result per requested ID, in request order
+     * @throws out_of_range if patron is not registered
+     * 
+     * Unlike checkoutItem, a missing or already checked-out ID, or one past the
+     * patron's loan limit, does not throw; it is reported in its result and the
+     * remaining IDs are still processed. All items share one due date.
+     */
+    vector<CheckoutResult> checkoutItems(span<const ItemId> itemIds, PatronId patron);
+
+    /// @brief Checks out several items to the patron called checkOutBy, registering them if they are new and an item goes out
+    vector<CheckoutResult> checkoutItems(span<const ItemId> itemIds, const string& checkOutBy);
     
     /**
      * @brief Checks in a previously checked-out item
@@ -147,6 +647,64 @@ public:
      * removes the checkout record.
      */
     void checkinItem(const Item& item);
+
+    /**
+     * @brief Checks in a previously checked-out item by ID
+     * @param itemId ID of the item to check in
+     * @throws runtime_error if the item is not checked out or its original compartment is occupied
+     */
+    void checkinItem(ItemId itemId);
+
+    /**
+     * @brief Checks in several items in one pass
+     * @param itemIds IDs of the returned items, in any order
+     * @return Count of items returned and the IDs that could not be
+     * 
+     * Items are written back in shelf order and their checkout records are removed
+     * together. IDs that are not checked out, or whose compartment has since been
+     * filled, are reported instead of thrown and do not stop the rest of the batch.
+     */
+    CheckinReport checkinItems(span<const ItemId> itemIds);
+
+    /**
+     * @brief Registers a patron
+     * @param name Patron's name
+     * @return The patron's ID; a name registered before keeps its ID
+     */
+    PatronId registerPatron(string_view name);
+
+    /// @return The patron called name, or nullopt if no one by that name is registered
+    optional<PatronId> findPatron(string_view name) const;
+
+    /**
+     * @return The patron's name
+     * @throws out_of_range if patron is not registered
+     */
+    const string& patronName(PatronId patron) const;
+
+    /**
+     * @brief Sets the most items a patron may have out at once
+     * @param patron Patron to limit
+     * @param limit Loan limit; PatronRegistry::unlimited, the default, removes it
+     * @throws out_of_range if patron is not registered
+     * 
+     * Items the patron already has out stay out even if they exceed the limit.
+     */
+    void setLoanLimit(PatronId patron, uint32_t limit);
+
+    /**
+     * @return IDs of the items the patron has checked out, in no particular order
+     * @throws out_of_range if patron is not registered
+     */
+    vector<ItemId> loansOf(PatronId patron) const;
+
+    /**
+     * @brief Renews the loan of a checked-out item
+     * @param itemId ID of the item to renew
+     * @return Its new due date, 30 days from today, as days since 1970-01-01
+     * @throws runtime_error if the item is not checked out
+     */
+    int32_t renewItem(ItemId itemId);
     
     /**
      * @brief Swaps the positions of two items in the inventory
@@ -159,12 +717,34 @@ public:
      */
     void swapItems(const Position& pos1, const Position& pos2);
     
+    /**
+     * @brief Calls a function for every item currently on a shelf
+     * @param f Callable as f(const Position&, const auto& item)
+     * 
+     * Visits compartments in memory order. Under InlineStorage f receives each item
+     * by its concrete type, so no virtual call is needed to read type-specific fields.
+     */
+    template <typename F>
+    void forEachItem(F&& f) const;
+
+    /**
+     * @brief Copies the whole catalog into one array per field
+     * @param recycled A previous export to overwrite; reusing its memory makes a
+     *        periodic export noticeably faster
+     * @return Every shelved item, then every checked-out item; see CatalogColumns
+     * 
+     * The inventory is locked for the whole copy, so the export is consistent:
+     * every item appears exactly once, as it was at a single moment. Changes made
+     * on other threads wait until the copy is done.
+     */
+    CatalogColumns exportColumns(CatalogColumns recycled = {}) const;
+
     /**
      * @brief Prints all items currently stored in the inventory
      * 
      * Displays shelf and compartment locations along with item details.
      */
-    friend ostream& operator<<(ostream& os, const Inventory& inventory);
+    friend ostream& operator<< <>(ostream& os, const BasicInventory& inventory);
 
 
     /**
@@ -174,6 +754,158 @@ public:
      * when it's due, and the item details.
      */
     void printCheckedOutItems() const;
+
+    /**
+     * @brief Prints the items one patron has checked out
+     * @throws out_of_range if patron is not registered
+     * 
+     * Reads only the patron's own loans, however many items are checked out.
+     */
+    void printCheckedOutItems(PatronId patron) const;
+
+    /**
+     * @brief Writes the whole inventory to a binary snapshot file
+     * @param path File to write; it is replaced only once the snapshot is complete
+     * @param nextId Caller's next unused item ID, stored so it survives a restart
+     * @throws runtime_error if the file cannot be written
+     * 
+     * The snapshot holds every shelved item, every checkout record and nextId,
+     * in the versioned format described in Snapshot.h. It stands alone: use
+     * checkpoint() to maintain the snapshot a journal is replayed on top of.
+     */
+    void saveSnapshot(const string& path, ItemId nextId = 0) const;
+
+    /**
+     * @brief Replaces the contents of the inventory with a snapshot
+     * @param path File written by saveSnapshot or checkpoint
+     * @return The largest nextId stored in the snapshot and its deltas
+     * @throws runtime_error if a file is missing, corrupt or of another version,
+     *         or its shelf layout differs from a fixed layout
+     * @throws invalid_argument if it holds an item this storage policy cannot hold
+     * 
+     * The deltas checkpointed after the snapshot are applied on top of it, and
+     * later checkpoints to path continue its chain. A runtime-sized inventory
+     * takes on the snapshot's shelf layout. Shelves are decoded in parallel. If
+     * loading fails the inventory is left unchanged.
+     */
+    ItemId loadSnapshot(const string& path);
+
+    /**
+     * @brief Makes every change so far durable in the checkpoint chain at path
+     * @param path Base snapshot of the chain
+     * @param options The caller's next item ID, and when to merge the chain into a new base snapshot
+     * @throws runtime_error if a file cannot be written; the changes stay marked
+     *         for the next checkpoint and the journal keeps their records
+     * 
+     * The first checkpoint to a path writes a full snapshot; later ones write a
+     * delta of only the shelves and checkout records changed since the previous
+     * checkpoint. Once the checkpoint is durable the attached journal drops the
+     * records it covers, and the chain is compacted when it has grown too long.
+     * 
+     * Meant to run on a background thread, typically from a Checkpointer, while
+     * another thread keeps changing the inventory: changes wait only while the
+     * dirty shelves are encoded in memory, not while they are written.
+     */
+    void checkpoint(const string& path, const CheckpointOptions& options = {});
+
+    /**
+     * @brief Logs every later change to journal
+     * @param journal Journal to append to, or nullptr to stop journaling; must
+     *        outlive the inventory or be detached first
+     * 
+     * Adds, checkouts, checkins, renewals and swaps are logged once they have
+     * succeeded, and the call returns only when the record is as durable as the
+     * journal's mode promises. Once a journal write has failed, every change is
+     * refused with its error before anything is changed. A write that fails just
+     * after its change was made leaves the change in place; the error is then
+     * reported by the next change or by Journal::flush().
+     */
+    void attachJournal(Journal* journal);
+
+    /**
+     * @brief Re-applies the changes recorded in a journal
+     * @param path Journal file; a missing file means there is nothing to replay
+     * @return Number of changes applied
+     * @throws logic_error if a journal is attached, since replay would log every change again
+     * @throws runtime_error, out_of_range if a record does not apply to the current state
+     * 
+     * Call on top of the snapshot the journal was started after. Changes already
+     * in the loaded checkpoint chain are skipped. Replay stops at a torn record
+     * at the end of the journal, which is what a crash leaves.
+     */
+    size_t replayJournal(const string& path);
+
+    /**
+     * @brief Finds the books by an author
+     * @param author Author as stored on the books
+     * @return Every such book, shelved or checked out, in no particular order
+     */
+    vector<ItemLocation> findByAuthor(string_view author) const;
+
+    /// @brief Finds the movies by a director; see findByAuthor
+    vector<ItemLocation> findByDirector(string_view director) const;
+
+    /// @brief Finds the movies an actor is among the main actors of; see findByAuthor
+    vector<ItemLocation> findByActor(string_view actor) const;
+
+    /// @brief Finds the books, magazines and movies with exactly this title; see findByAuthor
+    vector<ItemLocation> findByTitle(string_view title) const;
+
+    /**
+     * @brief Finds the books with a copyright date in a year; see findByAuthor
+     * @param year Year as it appears in the copyright date, such as 1999 for "1999-05-01"
+     */
+    vector<ItemLocation> findByCopyrightYear(int year) const;
+
+    /**
+     * @brief Finds items by the words in their names, descriptions and titles
+     * @param query Words to look for, in any case; a word ending in '*', such as
+     *        "astro*", also matches every longer word that starts with it
+     * @param mode Whether an item must contain all of the words or any of them
+     * @param limit Most items to return, or 0 for every match
+     * @return The best matches first, ranked by how many times the words occur in
+     *         each item; ties go to the lower ID
+     */
+    vector<SearchHit> searchText(string_view query, SearchMode mode = SearchMode::All, size_t limit = 20) const;
+
+    /**
+     * @brief Finds the checked-out items that are overdue on a day
+     * @param day Days since 1970-01-01, usually today()
+     * @return Every item due before day, earliest due first
+     */
+    vector<DueLoan> overdueAsOf(int32_t day) const;
+
+    /**
+     * @brief Finds the checked-out items due within a range of days
+     * @param first First day of the range, as days since 1970-01-01
+     * @param last Last day of the range, included
+     * @return Every item due from first to last, earliest due first
+     */
+    vector<DueLoan> dueBetween(int32_t first, int32_t last) const;
+
+    /**
+     * @brief Advances the loan timers to a day and collects the events that fired
+     * @param day Days since 1970-01-01, usually today()
+     * @return A DueSoon reminder for each loan that has come within the reminder
+     *         lead of its due date, and an Overdue notice for each loan whose due
+     *         date has passed, since the previous poll
+     * 
+     * Each open loan produces each event once; renewing it starts over. Events
+     * are not saved in snapshots, so after a restart the loans still open
+     * report the events they are due again.
+     */
+    vector<LoanEvent> pollLoanEvents(int32_t day);
+
+    /**
+     * @brief Sets how many days before its due date a loan's reminder fires
+     * @param days Lead time in days; 0 sends no reminders
+     * 
+     * Applies to loans checked out or renewed from now on.
+     */
+    void setReminderLead(int days);
+
+    /// @return The largest ID of any shelved or checked-out item, or nullopt if there are none
+    optional<ItemId> highestItemId() const;
     
     /**
      * @brief Checks if a compartment is empty
@@ -193,6 +925,31 @@ public:
      * Helper method used to verify item checkout status.
      */
     bool isItemCheckedOut(const string& itemId) const;
+
+    /**
+     * @brief Checks if an item is currently checked out
+     * @param itemId Integer ID of the item to check
+     * @return true if item is checked out, false otherwise
+     */
+    bool isItemCheckedOut(ItemId itemId) const;
 };
 
+/// Inventory whose shelf layout is chosen at run time
+using Inventory = BasicInventory<DynamicGeometry>;
+
+/// Runtime-sized inventory storing item values inline in its compartments
+using InlineInventory = BasicInventory<DynamicGeometry, InlineStorage>;
+
+/// Inventory whose shelf layout is fixed at compile time
+template <int Shelves, int Compartments, typename Storage = PooledStorage>
+using FixedInventory = BasicInventory<FixedGeometry<Shelves, Compartments>, Storage>;
+
+// The runtime-sized inventories are compiled once in Inventory.cpp
+extern template class BasicInventory<DynamicGeometry, PooledStorage>;
+extern template ostream& operator<<(ostream& os, const BasicInventory<DynamicGeometry, PooledStorage>& inventory);
+extern template class BasicInventory<DynamicGeometry, InlineStorage>;
+extern template ostream& operator<<(ostream& os, const BasicInventory<DynamicGeometry, InlineStorage>& inventory);
+
+#include "Inventory.tpp"
+
 #endif //INVENTORY_H
@@ -0,0 +1,1828 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef INVENTORY_TPP
+#define INVENTORY_TPP
+
+#include "Inventory.h"
+#include "Checkpoint.h"
+#include "Journal.h"
+#include "MappedFile.h"
+#include "Snapshot.h"
+#include <stdexcept>
+#include <iostream>
+#include <bit>
+#include <algorithm>
+#include <charconv>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+/**
+ * Constructor implementation
+ * 
+ * The geometry policy validates the dimensions up front so that every later bound
+ * check can rely on both being positive. All compartments are allocated in a single
+ * row-major block (a vector, or an embedded array for fixed layouts), which
+ * value-initializes each unique_ptr to nullptr and keeps neighbouring compartments
+ * of a shelf next to each other in memory.
+ */
+template <typename Geometry, typename Storage>
+template <typename... Args>
+    requires constructible_from<Geometry, Args...>
+BasicInventory<Geometry, Storage>::BasicInventory(Args&&... args)
+    : geometry(std::forward<Args>(args)...),
+      // Initialize all compartments to nullptr (empty)
+      shelves(geometry.template makeArray<Slot>(geometry.size())),
+      occupancy(geometry.makeOccupancyStorage()),
+      dirtyShelves((static_cast<size_t>(geometry.shelfCount()) + 63) / 64) {
+    markPadding(geometry, occupancy);
+}
+
+/**
+ * Padding bits
+ * 
+ * Sets the bits past the last compartment of each shelf, so a free-compartment
+ * scan never mistakes them for empty compartments.
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::markPadding(const Geometry& layout, typename Geometry::OccupancyStorage& bits) {
+    const int tailBits = layout.compartmentsPerShelf() % 64;
+    if (tailBits != 0) {
+        const uint64_t padding = ~uint64_t{0} << tailBits;
+        for (int shelf = 0; shelf < layout.shelfCount(); shelf++) {
+            bits[static_cast<size_t>(shelf + 1) * layout.wordsPerShelf() - 1] = padding;
+        }
+    }
+}
+
+/**
+ * Destructor implementation
+ * 
+ * A loan does not know which pool its item came from, so each one still open is
+ * reclaimed through the storage policy, and the slot that comes back frees the
+ * item in its pool as it goes out of scope. Everything else is released by
+ * the members' own destructors, the storage (and with it the pool) last.
+ */
+template <typename Geometry, typename Storage>
+BasicInventory<Geometry, Storage>::~BasicInventory() {
+    for (auto& entry : checkedOutItems) storage.reclaim(entry.value.item);
+}
+
+/**
+ * Helper method to convert integer IDs to string representation
+ * 
+ * This centralized conversion method ensures consistent string ID formatting
+ * throughout the codebase. By isolating this conversion logic, we make the code
+ * more maintainable - if we ever need to change the ID format (e.g., add prefixes
+ * or zero-padding), we only need to modify this one function.
+ */
+template <typename Geometry, typename Storage>
+string BasicInventory<Geometry, Storage>::getStringId(int id) {
+    return to_string(id);
+}
+
+/**
+ * Helper method to convert string IDs back to integers
+ * 
+ * from_chars is used rather than stoi because it neither allocates nor throws,
+ * and it lets us reject trailing garbage such as "12abc". A string that does not
+ * parse simply cannot match any item, which callers report as "not found".
+ */
+template <typename Geometry, typename Storage>
+bool BasicInventory<Geometry, Storage>::parseItemId(const string& itemId, ItemId& id) {
+    const char* first = itemId.data();
+    const char* last = first + itemId.size();
+    auto [ptr, ec] = from_chars(first, last, id);
+    return ec == errc() && ptr == last;
+}
+
+/**
+ * Position validation against the configured geometry
+ * 
+ * Every bound check in the class funnels through here, so the shelf and
+ * compartment limits are only ever read from the geometry policy. For a
+ * FixedGeometry both limits are constants the compiler can fold.
+ */
+template <typename Geometry, typename Storage>
+bool BasicInventory<Geometry, Storage>::isValidPosition(const Position& pos) const {
+    return geometry.isValid(pos);
+}
+
+/**
+ * Row-major compartment lookup
+ * 
+ * Callers validate the position first; keeping the index arithmetic in one place
+ * means the storage layout can change without touching the public methods.
+ */
+template <typename Geometry, typename Storage>
+typename Storage::Slot& BasicInventory<Geometry, Storage>::compartmentAt(const Position& pos) {
+    return shelves[geometry.indexOf(pos)];
+}
+
+template <typename Geometry, typename Storage>
+const typename Storage::Slot& BasicInventory<Geometry, Storage>::compartmentAt(const Position& pos) const {
+    return shelves[geometry.indexOf(pos)];
+}
+
+/**
+ * Occupancy bitmap update
+ * 
+ * Every mutator that fills or empties a compartment calls this, keeping the
+ * bitmap an exact mirror of which unique_ptrs in shelves are non-null. That also
+ * makes it the one place that marks a shelf as changed for the next checkpoint;
+ * only swapItems, which leaves occupancy alone, has to mark its shelves itself.
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::setOccupied(const Position& pos, bool occupied) {
+    const size_t word = static_cast<size_t>(pos.getRow()) * geometry.wordsPerShelf() + pos.getCol() / 64;
+    const uint64_t bit = uint64_t{1} << (pos.getCol() % 64);
+    if (occupied) {
+        occupancy[word] |= bit;
+    } else {
+        occupancy[word] &= ~bit;
+    }
+    markDirty(pos);
+}
+
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::markDirty(const Position& pos) {
+    dirtyShelves[static_cast<size_t>(pos.getRow()) / 64] |= uint64_t{1} << (pos.getRow() % 64);
+}
+
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::markCheckoutDirty(ItemId id) {
+    dirtyCheckouts.emplace(id, true);
+}
+
+/**
+ * Operator overloading for non-const shelf access
+ * 
+ * This implementation of the [] operator enables intuitive, array-like access
+ * to shelves and compartments using syntax like: inventory[2][3]. The bound
+ * checking ensures that invalid shelf indices are caught immediately with a
+ * descriptive exception rather than causing undefined behavior or silent failures.
+ */
+template <typename Geometry, typename Storage>
+typename Storage::Slot* BasicInventory<Geometry, Storage>::operator[](int shelfIndex) {
+    if (shelfIndex < 0 || shelfIndex >= geometry.shelfCount()) throw out_of_range("Shelf index out of range");
+    return shelves.data() + geometry.indexOf(Position(shelfIndex, 0));
+}
+
+/**
+ * Operator overloading for const shelf access
+ * 
+ * Having separate const and non-const versions of the [] operator is a C++ best
+ * practice that enables proper const-correctness. This ensures that const Inventory
+ * objects can still be accessed for reading but not for modification, maintaining
+ * the integrity of the const contract.
+ */
+template <typename Geometry, typename Storage>
+const typename Storage::Slot* BasicInventory<Geometry, Storage>::operator[](int shelfIndex) const {
+    if (shelfIndex < 0 || shelfIndex >= geometry.shelfCount()) throw out_of_range("Shelf index out of range");
+    return shelves.data() + geometry.indexOf(Position(shelfIndex, 0));
+}
+
+/**
+ * Checks if a compartment at the specified position is empty
+ * 
+ * This utility method abstracts the logic for checking empty compartments,
+ * providing position validation as a safeguard. I factored this into a separate
+ * method to avoid code duplication, as this check is needed in multiple places.
+ * The explicit validity check prevents accessing invalid array indices.
+ */
+template <typename Geometry, typename Storage>
+bool BasicInventory<Geometry, Storage>::isCompartmentEmpty(const Position& pos) const {
+    if (!isValidPosition(pos)) throw out_of_range("Position is out of range");
+    return !Storage::occupied(compartmentAt(pos));
+}
+
+/**
+ * Checks if an item with the given ID is currently checked out
+ * 
+ * The string overload only exists for callers holding user input; it parses the
+ * ID once and defers to the integer overload, which is a single hash probe into
+ * checkedOutItems.
+ */
+template <typename Geometry, typename Storage>
+bool BasicInventory<Geometry, Storage>::isItemCheckedOut(const string& itemId) const {
+    ItemId id;
+    return parseItemId(itemId, id) && isItemCheckedOut(id);
+}
+
+template <typename Geometry, typename Storage>
+bool BasicInventory<Geometry, Storage>::isItemCheckedOut(ItemId itemId) const {
+    return checkedOutItems.contains(itemId);
+}
+
+/**
+ * Placement checks shared by every way of adding an item
+ * 
+ * Splitting validation from the actual store lets each addItem overload run all
+ * checks before it copies, moves or adopts anything, so a failed insert never
+ * leaves the caller's item half-moved.
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::checkPlacement(const Position& position) const {
+    // Validate position
+    if (!isValidPosition(position)) {
+        throw out_of_range("Position is out of valid range");
+    }
+    
+    // Check if the compartment is empty
+    if (!isCompartmentEmpty(position)) {
+        throw runtime_error("Compartment is not empty");
+    }
+}
+
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::checkNewId(ItemId id) const {
+    // IDs must be unique for the position index to be meaningful
+    if (itemPositions.contains(id) || isItemCheckedOut(id)) {
+        throw runtime_error("Item with ID " + getStringId(id) + " already exists");
+    }
+}
+
+/**
+ * If an index cannot grow, the item is taken out of the others and its
+ * compartment is emptied again, so a failed add leaves no trace. unstore gets
+ * the slot first, which is how addItem(Item&&) hands the contents it moved in
+ * back to the caller.
+ */
+template <typename Geometry, typename Storage>
+template <typename Unstore>
+void BasicInventory<Geometry, Storage>::recordPlacement(const Position& position, ItemId id, Unstore unstore) {
+    Slot& slot = compartmentAt(position);
+    try {
+        itemPositions.emplace(id, position);
+        itemIndex.add(Storage::get(slot));
+        textIndex.add(Storage::get(slot));
+    } catch (...) {
+        itemIndex.remove(Storage::get(slot));
+        itemPositions.erase(id);
+        unstore(slot);
+        slot = Slot();
+        throw;
+    }
+    setOccupied(position, true);
+}
+
+/**
+ * Adds an item to the inventory at the specified position
+ * 
+ * This method demonstrates several important concepts:
+ * 1. Input validation - checking position validity and compartment availability
+ * 2. Polymorphism - maintaining the specific derived item type (Book, Movie, etc.)
+ * 3. Memory safety - using smart pointers to prevent leaks
+ * 
+ * The storage policy copies the item by its exact dynamic type, preserving all
+ * specific properties of derived item types. This enables proper polymorphic
+ * behavior where specific item details (like book author or movie actors) are
+ * maintained even through the inventory system.
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::addItem(const Position& position, const Item& item) {
+    lock_guard guard(stateLock);
+    checkPlacement(position);
+    checkNewId(item.getID());
+    StagedChange logged(journal);
+    if (journal) journal->logAdd(position, item);
+
+    compartmentAt(position) = storage.make(item);
+    recordPlacement(position, item.getID(), [](Slot&) {});
+    logged.commit();
+}
+
+/**
+ * Adds an item by moving from it
+ * 
+ * Every string and the actor list are handed over rather than deep-copied, which
+ * is what callers holding a temporary (such as the menu in main.cpp) want.
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::addItem(const Position& position, Item&& item) {
+    lock_guard guard(stateLock);
+    checkPlacement(position);
+    const ItemId id = item.getID();
+    checkNewId(id);
+    StagedChange logged(journal);
+    if (journal) journal->logAdd(position, item);
+
+    compartmentAt(position) = storage.make(std::move(item));
+    recordPlacement(position, id, [&](Slot& slot) {
+        withConcreteItem(std::move(item), [&]<typename T>(T&& target) {
+            target = std::move(static_cast<remove_cvref_t<T>&>(Storage::get(slot)));
+        });
+    });
+    logged.commit();
+}
+
+/**
+ * Adds a heap-allocated item by taking ownership of it
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::addItem(const Position& position, unique_ptr<Item> item) {
+    if (!item) {
+        throw invalid_argument("Item must not be null");
+    }
+    lock_guard guard(stateLock);
+    checkPlacement(position);
+    const ItemId id = item->getID();
+    checkNewId(id);
+    StagedChange logged(journal);
+    if (journal) journal->logAdd(position, *item);
+
+    compartmentAt(position) = storage.adopt(std::move(item));
+    recordPlacement(position, id, [](Slot&) {});
+    logged.commit();
+}
+
+/**
+ * Constructs an item in place
+ * 
+ * The item's ID is only known once it exists, so the ID check runs after
+ * construction; on a duplicate the freshly built item is destroyed again and the
+ * compartment is left empty.
+ */
+template <typename Geometry, typename Storage>
+template <typename T, typename... Args>
+    requires (Storage::template holds<T>)
+T& BasicInventory<Geometry, Storage>::emplaceItem(const Position& position, Args&&... args) {
+    lock_guard guard(stateLock);
+    checkPlacement(position);
+    StagedChange logged(journal);
+
+    Slot& slot = compartmentAt(position);
+    storage.template emplace<T>(slot, std::forward<Args>(args)...);
+    T& item = static_cast<T&>(Storage::get(slot));
+    try {
+        checkNewId(item.getID());
+        if (journal) journal->logAdd(position, item);
+    } catch (...) {
+        slot = Slot();
+        throw;
+    }
+
+    recordPlacement(position, item.getID(), [](Slot&) {});
+    logged.commit();
+    return item;
+}
+
+/**
+ * Batch insertion
+ * 
+ * The per-item checks of addItem are run for the whole batch up front, plus two
+ * that only make sense for a batch: no compartment may be targeted twice and no
+ * ID may appear twice. Sorting the batch by row-major index exposes repeated
+ * positions as neighbours and lets the stores walk the shelves in memory order;
+ * batches that arrive already in shelf order skip the sort. The ID index is grown
+ * once and filled before any item is stored, which doubles as the duplicate-ID
+ * check. After that the only things that can fail are staging the journal records
+ * and the storage policy allocating an item, and those are undone through unstore
+ * so the batch stays all-or-nothing.
+ */
+template <typename Geometry, typename Storage>
+template <typename Entry, typename ItemOf, typename Store, typename Unstore>
+void BasicInventory<Geometry, Storage>::insertBatch(span<Entry> items, ItemOf itemOf, Store store, Unstore unstore) {
+    lock_guard guard(stateLock);
+    StagedChange logged(journal);
+    for (auto& entry : items) {
+        const Item* item = itemOf(entry);
+        if (item == nullptr) {
+            throw invalid_argument("Item must not be null");
+        }
+        if (!Storage::accepts(*item)) {
+            throw invalid_argument("Unsupported item type");
+        }
+        checkPlacement(entry.first);
+    }
+
+    // Sort (compartment index, batch index) pairs rather than batch indices so the
+    // comparisons never have to reach back into the batch
+    vector<pair<size_t, size_t>> order(items.size());
+    for (size_t i = 0; i < items.size(); i++) {
+        order[i] = {geometry.indexOf(items[i].first), i};
+    }
+    if (!is_sorted(order.begin(), order.end())) {
+        sort(order.begin(), order.end());
+    }
+    for (size_t i = 1; i < order.size(); i++) {
+        if (order[i].first == order[i - 1].first) {
+            throw runtime_error("Batch targets the same compartment twice");
+        }
+    }
+
+    // Index every ID up front; a failed emplace means the ID is already shelved
+    // or repeated earlier in the batch
+    itemPositions.reserve(itemPositions.size() + items.size());
+    auto unindex = [&](size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            itemPositions.erase(itemOf(items[order[i].second])->getID());
+        }
+    };
+    for (size_t i = 0; i < order.size(); i++) {
+        const auto& entry = items[order[i].second];
+        const ItemId id = itemOf(entry)->getID();
+        if (isItemCheckedOut(id) || !itemPositions.emplace(id, entry.first).second) {
+            unindex(i);
+            throw runtime_error("Item with ID " + getStringId(id) + " already exists");
+        }
+    }
+
+    size_t stored = 0;
+    try {
+        if (journal) {
+            for (const auto& [index, i] : order) journal->logAdd(items[i].first, *itemOf(items[i]));
+        }
+        for (; stored < order.size(); stored++) {
+            auto& entry = items[order[stored].second];
+            store(compartmentAt(entry.first), entry);
+            setOccupied(entry.first, true);
+        }
+        for (const auto& [index, i] : order) {
+            itemIndex.add(Storage::get(compartmentAt(items[i].first)));
+            textIndex.add(Storage::get(compartmentAt(items[i].first)));
+        }
+    } catch (...) {
+        while (stored-- > 0) {
+            auto& entry = items[order[stored].second];
+            Slot& slot = compartmentAt(entry.first);
+            itemIndex.remove(Storage::get(slot));
+            textIndex.remove(Storage::get(slot));
+            setOccupied(entry.first, false);
+            unstore(slot, entry);
+            slot = Slot();
+        }
+        unindex(order.size());
+        throw;
+    }
+    logged.commit();
+}
+
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::addItems(span<pair<Position, unique_ptr<Item>>> items) {
+    using Entry = pair<Position, unique_ptr<Item>>;
+    insertBatch(items,
+        [](const Entry& entry) -> const Item* { return entry.second.get(); },
+        [this](Slot& slot, Entry& entry) { slot = storage.adopt(std::move(entry.second)); },
+        [](Slot& slot, Entry& entry) { entry.second = Storage::release(slot); });
+}
+
+template <typename Geometry, typename Storage>
+template <derived_from<Item> T>
+    requires (Storage::template holds<T>)
+void BasicInventory<Geometry, Storage>::addItems(span<pair<Position, T>> items) {
+    using Entry = pair<Position, T>;
+    insertBatch(items,
+        [](const Entry& entry) -> const Item* { return &entry.second; },
+        [this](Slot& slot, Entry& entry) { storage.template emplace<T>(slot, std::move(entry.second)); },
+        [](Slot& slot, Entry& entry) { entry.second = std::move(static_cast<T&>(Storage::get(slot))); });
+}
+
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::addItems(span<pair<Position, ItemValue>> items) {
+    using Entry = pair<Position, ItemValue>;
+    insertBatch(items,
+        [](const Entry& entry) { return std::visit([](const Item& item) { return &item; }, entry.second); },
+        [this](Slot& slot, Entry& entry) {
+            std::visit([&]<typename T>(T& item) { storage.template emplace<T>(slot, std::move(item)); }, entry.second);
+        },
+        [](Slot& slot, Entry& entry) {
+            std::visit([&]<typename T>(T& item) { item = std::move(static_cast<T&>(Storage::get(slot))); }, entry.second);
+        });
+}
+
+/**
+ * Finds the first empty compartment
+ * 
+ * Rather than probing compartments one by one, this inverts each occupancy word
+ * and uses countr_zero to jump straight to the lowest free bit. A fully occupied
+ * shelf segment therefore costs one comparison per 64 compartments. Because the
+ * padding bits are kept set, a set bit in the inverted word always names a real
+ * compartment.
+ */
+template <typename Geometry, typename Storage>
+optional<Position> BasicInventory<Geometry, Storage>::findFreeCompartment() const {
+    const int wordsPerShelf = geometry.wordsPerShelf();
+    for (size_t word = 0; word < occupancy.size(); word++) {
+        const uint64_t free = ~occupancy[word];
+        if (free != 0) {
+            const int shelf = static_cast<int>(word / wordsPerShelf);
+            const int compartment = static_cast<int>(word % wordsPerShelf) * 64 + countr_zero(free);
+            return Position(shelf, compartment);
+        }
+    }
+    return nullopt;
+}
+
+/**
+ * Adds an item to the first empty compartment
+ * 
+ * This is the placement path for bulk receiving, where the caller does not care
+ * which compartment an item lands in. It reuses addItem so that ID uniqueness and
+ * index maintenance are enforced in exactly one place.
+ */
+template <typename Geometry, typename Storage>
+Position BasicInventory<Geometry, Storage>::addItemAnywhere(const Item& item) {
+    lock_guard guard(stateLock);
+    const optional<Position> position = findFreeCompartment();
+    if (!position) {
+        throw runtime_error("No empty compartment available");
+    }
+    addItem(*position, item);
+    return *position;
+}
+
+template <typename Geometry, typename Storage>
+Position BasicInventory<Geometry, Storage>::addItemAnywhere(Item&& item) {
+    lock_guard guard(stateLock);
+    const optional<Position> position = findFreeCompartment();
+    if (!position) {
+        throw runtime_error("No empty compartment available");
+    }
+    addItem(*position, std::move(item));
+    return *position;
+}
+
+/**
+ * Checks out an item from the inventory
+ * 
+ * This method handles the complex process of finding an item by ID, generating
+ * a due date, and transferring ownership of the item from the shelf to the 
+ * checked-out items collection. Key design decisions include:
+ * 
+ * 1. Returning a raw pointer to the item rather than a reference or copy, allowing
+ *    the caller to access but not own the item (ownership remains with the inventory)
+ * 
+ * 2. Using C++'s time utilities to generate a realistic due date 30 days in the future
+ * 
+ * 3. Employing std::exchange to move the compartment contents (a unique_ptr or an inline
+ *    value) into the checkout record and leave the compartment empty in one step
+ * 
+ * 4. Storing the original position to ensure the item can be returned to its proper place
+ * 
+ * 5. Locating the item through the itemPositions index, so the cost of a checkout
+ *    does not depend on how many compartments the library has
+ * 
+ * The itemPtr approach allows us to return a pointer to the checked-out item while
+ * maintaining the ownership semantics of unique_ptr. With InlineStorage the item
+ * lives inside the checkout table, so the pointer is only valid until the next
+ * mutation of the inventory.
+ */
+template <typename Geometry, typename Storage>
+Item* BasicInventory<Geometry, Storage>::checkoutItem(const string& itemId, PatronId patron) {
+    lock_guard guard(stateLock);
+    checkPatron(patron);
+    // Find the item with the given ID through the position index
+    ItemId id;
+    const Position* found = parseItemId(itemId, id) ? itemPositions.find(id) : nullptr;
+    if (found == nullptr) {
+        throw runtime_error("Item with ID " + itemId + " not found");
+    }
+    const Position pos = *found;
+    if (patrons.atLoanLimit(patron)) {
+        throw runtime_error(patrons.name(patron) + " already has " + to_string(patrons.loanLimit(patron)) +
+                            " items checked out, the most allowed");
+    }
+    
+    // Return pointer to the checked-out item
+    StagedChange logged(journal);
+    Item* item = moveToCheckout(id, pos, patron, makeDueDay());
+    logged.commit();
+    return item;
+}
+
+/**
+ * Checkout by patron name
+ * 
+ * Registering a patron is permanent, so an unknown name is only interned once
+ * the item is known to be on a shelf; a mistyped ID or an item that is already
+ * out then registers nobody. A new patron has no loans and no limit, so the
+ * checkout cannot be refused after that.
+ */
+template <typename Geometry, typename Storage>
+Item* BasicInventory<Geometry, Storage>::checkoutItem(const string& itemId, const string& checkOutBy) {
+    lock_guard guard(stateLock);
+    if (const optional<PatronId> patron = patrons.find(checkOutBy)) {
+        return checkoutItem(itemId, *patron);
+    }
+    ItemId id;
+    if (!parseItemId(itemId, id) || !itemPositions.contains(id)) {
+        throw runtime_error("Item with ID " + itemId + " not found");
+    }
+    return checkoutItem(itemId, patrons.intern(checkOutBy));
+}
+
+/**
+ * Due date generation
+ * 
+ * Due dates are day numbers, so the date 30 days from now is an addition to the
+ * cached day number of today; it is only formatted when a checkout is printed.
+ */
+template <typename Geometry, typename Storage>
+int32_t BasicInventory<Geometry, Storage>::makeDueDay() {
+    return today() + 30;
+}
+
+/**
+ * Moves a shelved item into the checkout table
+ * 
+ * Shared by the single and batch checkout paths once they have located the item,
+ * and by journal replay, which does not apply loan limits: the checkouts it
+ * repeats were allowed when they were made. Everything that can fail happens
+ * before the item leaves its compartment: the journal record is staged, the
+ * checkout table is grown to take one more record, the record is marked dirty
+ * (harmless if the checkout then fails, as the next delta just restates it),
+ * and the loan's timer, due index entry and patron loan are made, which can only
+ * leave each other to undo. The emplace that follows neither rehashes nor
+ * reallocates, so once the slot has moved the checkout completes and the caller
+ * commits the record.
+ */
+template <typename Geometry, typename Storage>
+Item* BasicInventory<Geometry, Storage>::moveToCheckout(ItemId id, const Position& pos, PatronId patron, int32_t dueDay) {
+    static_assert(is_nothrow_move_constructible_v<CheckoutRecord>, "Moving the item into the table must not fail");
+    if (journal) journal->logCheckout(id, patrons.name(patron), dueDay);
+    checkedOutItems.reserve(checkedOutItems.size() + 1);
+    markCheckoutDirty(id);
+    const TimerHandle timer = scheduleLoanTimer(loanTimers, id, dueDay);
+    try {
+        dueIndex.add(id, dueDay);
+        try {
+            patrons.addLoan(patron, id);
+        } catch (...) {
+            dueIndex.remove(id);
+            throw;
+        }
+    } catch (...) {
+        loanTimers.cancel(timer);
+        throw;
+    }
+
+    // Move the compartment contents into the checkout table, leaving it empty
+    auto [info, inserted] = checkedOutItems.emplace(
+        id, 
+        CheckoutRecord(patron, dueDay, static_cast<uint32_t>(geometry.indexOf(pos)), Storage::lend(exchange(compartmentAt(pos), Slot())))
+    );
+    info->timer = timer;
+    itemPositions.erase(id);
+    setOccupied(pos, false);
+    return &Storage::get(info->item);
+}
+
+/**
+ * Checks out a stack of items for one patron
+ * 
+ * Each ID costs one probe into the position index, the due date is generated
+ * once, and the checkout table is grown once for the whole stack. Misses are
+ * reported per ID rather than thrown, so one bad barcode does not stop the rest
+ * of the stack from going out. Because the table does not grow while the batch
+ * runs, every returned pointer is valid when the call returns. Each checkout is
+ * journaled as soon as it is made, so a failure part-way through leaves the
+ * journal matching the items that did go out.
+ */
+template <typename Geometry, typename Storage>
+vector<CheckoutResult> BasicInventory<Geometry, Storage>::checkoutItems(span<const ItemId> itemIds, PatronId patron) {
+    lock_guard guard(stateLock);
+    checkPatron(patron);
+    StagedChange logged(journal);
+    const int32_t dueDay = makeDueDay();
+    checkedOutItems.reserve(checkedOutItems.size() + itemIds.size());
+
+    vector<CheckoutResult> results;
+    results.reserve(itemIds.size());
+    for (const ItemId id : itemIds) {
+        if (const Position* found = itemPositions.find(id)) {
+            if (patrons.atLoanLimit(patron)) {
+                results.push_back({id, CheckoutStatus::LimitReached, nullptr});
+                continue;
+            }
+            const Position pos = *found;
+            Item* item = moveToCheckout(id, pos, patron, dueDay);
+            logged.commit();
+            results.push_back({id, CheckoutStatus::CheckedOut, item});
+        } else if (isItemCheckedOut(id)) {
+            results.push_back({id, CheckoutStatus::AlreadyCheckedOut, nullptr});
+        } else {
+            results.push_back({id, CheckoutStatus::NotFound, nullptr});
+        }
+    }
+    return results;
+}
+
+/**
+ * As for checkoutItem, an unknown name is only registered if at least one item
+ * of the stack is on a shelf and will go out.
+ */
+template <typename Geometry, typename Storage>
+vector<CheckoutResult> BasicInventory<Geometry, Storage>::checkoutItems(span<const ItemId> itemIds, const string& checkOutBy) {
+    lock_guard guard(stateLock);
+    if (const optional<PatronId> patron = patrons.find(checkOutBy)) {
+        return checkoutItems(itemIds, *patron);
+    }
+    if (any_of(itemIds.begin(), itemIds.end(), [this](ItemId id) { return itemPositions.contains(id); })) {
+        return checkoutItems(itemIds, patrons.intern(checkOutBy));
+    }
+
+    vector<CheckoutResult> results;
+    results.reserve(itemIds.size());
+    for (const ItemId id : itemIds) {
+        results.push_back({id, isItemCheckedOut(id) ? CheckoutStatus::AlreadyCheckedOut : CheckoutStatus::NotFound, nullptr});
+    }
+    return results;
+}
+
+/**
+ * Checks in a previously checked out item
+ * 
+ * This method demonstrates the full lifecycle of a library item - after being
+ * checked out, it can be returned to its original position. The implementation:
+ * 
+ * 1. Validates that the item is actually checked out
+ * 2. Retrieves the original position stored during checkout
+ * 3. Moves the item back to its shelf location
+ * 4. Cleans up the checkout record
+ * 
+ * I implemented this using the item's ID rather than requiring the exact same
+ * item object that was checked out. This approach is more user-friendly, as it
+ * only requires knowing the item's ID to check it back in.
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::checkinItem(ItemId itemId) {
+    lock_guard guard(stateLock);
+    // Check if the item is checked out
+    auto* info = checkedOutItems.find(itemId);
+    if (info == nullptr) {
+        throw runtime_error("Item is not checked out");
+    }
+    
+    // Get the original position
+    const Position pos = geometry.positionOf(info->home);
+    if (!isCompartmentEmpty(pos)) {
+        throw runtime_error("Original compartment is not empty");
+    }
+    StagedChange logged(journal);
+    if (journal) journal->logCheckin(itemId);
+    // Everything that can fail happens before the loan is emptied
+    itemPositions.reserve(itemPositions.size() + 1);
+    markCheckoutDirty(itemId);
+    
+    // Return the item to its original position
+    compartmentAt(pos) = storage.reclaim(info->item);
+    itemPositions.insert_or_assign(itemId, pos);
+    setOccupied(pos, true);
+    
+    // Remove from checked out items
+    if (info->timer != noTimer) loanTimers.cancel(info->timer);
+    patrons.removeLoan(info->patron, itemId);
+    checkedOutItems.erase(itemId);
+    dueIndex.remove(itemId);
+    logged.commit();
+}
+
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::checkinItem(const Item& item) {
+    checkinItem(item.getID());
+}
+
+/**
+ * Checks in a bin of returned items
+ * 
+ * The records are looked up first and sorted by the flat index of their original
+ * compartment, so the items are written back in the order the shelves lie in
+ * memory rather than in the order they came out of the bin. Each returned item
+ * leaves an empty slot behind in its record, which is what the single erase_if
+ * pass at the end keys on; the checkout table is compacted once instead of being
+ * repaired after every removal. That pass also runs if the batch fails part-way,
+ * so no record is left behind holding an empty slot. Each item is journaled as
+ * soon as it is back on its shelf.
+ * 
+ * Two records can name the same compartment if it was restocked and checked out
+ * again; the first to be written back wins and the other is reported as blocked,
+ * just as checkinItem would refuse it.
+ */
+template <typename Geometry, typename Storage>
+CheckinReport BasicInventory<Geometry, Storage>::checkinItems(span<const ItemId> itemIds) {
+    lock_guard guard(stateLock);
+    StagedChange logged(journal);
+    struct Return {
+        size_t index;
+        ItemId id;
+        CheckoutRecord* info;
+    };
+
+    CheckinReport report;
+    vector<Return> returns;
+    returns.reserve(itemIds.size());
+    for (const ItemId id : itemIds) {
+        if (auto* info = checkedOutItems.find(id)) {
+            returns.push_back({info->home, id, info});
+        } else {
+            report.notCheckedOut.push_back(id);
+        }
+    }
+    sort(returns.begin(), returns.end(), [](const Return& a, const Return& b) {
+        return a.index != b.index ? a.index < b.index : a.id < b.id;
+    });
+
+    // With room made up front, only the journal can fail once a return has begun,
+    // and it does so before the loan is emptied
+    itemPositions.reserve(itemPositions.size() + returns.size());
+    dirtyCheckouts.reserve(dirtyCheckouts.size() + returns.size());
+
+    // Only the records whose item went back to a shelf have an empty slot
+    auto compact = [this] {
+        checkedOutItems.erase_if([](const auto& entry) { return !Storage::occupied(entry.value.item); });
+    };
+    try {
+        for (size_t i = 0; i < returns.size(); i++) {
+            const Return& item = returns[i];
+            // The same ID scanned twice; it went back on the shelf the first time
+            if (i > 0 && returns[i - 1].id == item.id) continue;
+
+            const Position pos = geometry.positionOf(item.info->home);
+            if (isCompartmentEmpty(pos)) {
+                if (journal) journal->logCheckin(item.id);
+                markCheckoutDirty(item.id);
+                compartmentAt(pos) = storage.reclaim(item.info->item);
+                itemPositions.insert_or_assign(item.id, pos);
+                setOccupied(pos, true);
+                if (item.info->timer != noTimer) loanTimers.cancel(item.info->timer);
+                patrons.removeLoan(item.info->patron, item.id);
+                dueIndex.remove(item.id);
+                logged.commit();
+                report.returned++;
+            } else {
+                report.compartmentOccupied.push_back(item.id);
+            }
+        }
+    } catch (...) {
+        compact();
+        throw;
+    }
+    compact();
+    return report;
+}
+
+template <typename Geometry, typename Storage>
+int32_t BasicInventory<Geometry, Storage>::renewItem(ItemId itemId) {
+    lock_guard guard(stateLock);
+    StagedChange logged(journal);
+    const int32_t dueDay = makeDueDay();
+    extendLoan(itemId, dueDay);
+    logged.commit();
+    return dueDay;
+}
+
+/**
+ * Moves a loan to a new due date
+ * 
+ * Shared by renewItem and journal replay, which must reproduce the date that
+ * was logged rather than count 30 days from the day of the replay. The journal
+ * record, the new timer and the due index entry are made, and the record marked
+ * dirty, before the loan itself changes, so a failure leaves the old due date.
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::extendLoan(ItemId id, int32_t dueDay) {
+    auto* info = checkedOutItems.find(id);
+    if (info == nullptr) {
+        throw runtime_error("Item is not checked out");
+    }
+    if (journal) journal->logRenew(id, dueDay);
+    markCheckoutDirty(id);
+    const TimerHandle timer = scheduleLoanTimer(loanTimers, id, dueDay);
+    try {
+        dueIndex.add(id, dueDay);
+    } catch (...) {
+        loanTimers.cancel(timer);
+        throw;
+    }
+    if (info->timer != noTimer) loanTimers.cancel(info->timer);
+    info->timer = timer;
+    info->dueDay = dueDay;
+}
+
+/**
+ * Loan timers
+ * 
+ * A loan starts with its reminder, or with its overdue notice if reminders are
+ * off or it is already overdue; a reminder whose day has passed but whose loan
+ * is not yet overdue still fires, on the next poll.
+ */
+template <typename Geometry, typename Storage>
+TimerHandle BasicInventory<Geometry, Storage>::scheduleLoanTimer(TimerWheel<LoanTimer>& timers, ItemId id, int32_t dueDay) const {
+    if (reminderLead > 0 && timers.now() <= dueDay) {
+        return timers.schedule(dueDay - reminderLead, {id, LoanEventKind::DueSoon});
+    }
+    return timers.schedule(dueDay + 1, {id, LoanEventKind::Overdue});
+}
+
+/**
+ * Polling loan events
+ * 
+ * Firing a reminder frees its timer node just before the overdue timer that
+ * replaces it is scheduled, so the wheel reuses the node and this never allocates
+ * in the wheel; only the returned events do. The record's timer is updated before
+ * the event is appended, so if that append fails no record is left holding the
+ * handle of a timer that has already fired.
+ */
+template <typename Geometry, typename Storage>
+vector<LoanEvent> BasicInventory<Geometry, Storage>::pollLoanEvents(int32_t day) {
+    lock_guard guard(stateLock);
+    vector<LoanEvent> events;
+    loanTimers.advance(day, [&](int32_t, LoanTimer timer) {
+        auto* info = checkedOutItems.find(timer.id);
+        info->timer = timer.kind == LoanEventKind::DueSoon
+            ? loanTimers.schedule(info->dueDay + 1, {timer.id, LoanEventKind::Overdue})
+            : noTimer;
+        events.push_back({timer.id, timer.kind, info->dueDay, info->patron});
+    });
+    return events;
+}
+
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::setReminderLead(int days) {
+    lock_guard guard(stateLock);
+    if (days < 0) {
+        throw invalid_argument("Reminder lead cannot be negative");
+    }
+    reminderLead = days;
+}
+
+/**
+ * Swaps the positions of two items in the inventory
+ * 
+ * This method demonstrates the power of C++'s std::swap function combined with
+ * unique_ptr to perform a complex operation with minimal code. The implementation:
+ * 
+ * 1. Validates both positions to prevent out-of-bounds access
+ * 2. Verifies both compartments contain items to swap
+ * 3. Performs the swap using std::swap
+ * 
+ * Using std::swap with unique_ptr handles the ownership transfer correctly without
+ * any risk of memory leaks. This is significantly safer than manual pointer swapping
+ * which could lead to ownership issues or memory leaks.
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::swapItems(const Position& pos1, const Position& pos2) {
+    lock_guard guard(stateLock);
+    // Validate positions
+    if (!isValidPosition(pos1) || !isValidPosition(pos2)) {
+        throw out_of_range("Position is out of valid range");
+    }
+
+    // Check if both compartments have items
+    if (isCompartmentEmpty(pos1) || isCompartmentEmpty(pos2)) {
+        throw runtime_error("Cannot swap: one or both compartments are empty");
+    }
+    StagedChange logged(journal);
+    if (journal) journal->logSwap(pos1, pos2);
+    
+    // Swap the items
+    Slot& first = compartmentAt(pos1);
+    Slot& second = compartmentAt(pos2);
+    swap(first, second);
+
+    // Keep the position index pointing at the new compartments; both compartments
+    // were occupied before and still are, so the occupancy bitmap is unchanged
+    itemPositions.insert_or_assign(Storage::get(first).getID(), pos1);
+    itemPositions.insert_or_assign(Storage::get(second).getID(), pos2);
+    markDirty(pos1);
+    markDirty(pos2);
+    logged.commit();
+}
+
+/**
+ * Visits every shelved item
+ * 
+ * The occupancy bitmap is walked instead of the compartments themselves, so
+ * stretches of empty compartments are skipped a word at a time and only
+ * occupied compartments are ever touched.
+ */
+template <typename Geometry, typename Storage>
+template <typename F>
+void BasicInventory<Geometry, Storage>::forEachItem(F&& f) const {
+    const int wordsPerShelf = geometry.wordsPerShelf();
+    for (size_t word = 0; word < occupancy.size(); word++) {
+        const int shelf = static_cast<int>(word / wordsPerShelf);
+        const int base = static_cast<int>(word % wordsPerShelf) * 64;
+        uint64_t bits = occupancy[word];
+        // Padding bits past the end of a shelf are always set; mask them off
+        if (base + 64 > geometry.compartmentsPerShelf()) {
+            bits &= (uint64_t{1} << (geometry.compartmentsPerShelf() - base)) - 1;
+        }
+        while (bits != 0) {
+            const Position pos(shelf, base + countr_zero(bits));
+            Storage::visit(compartmentAt(pos), [&](const auto& item) { f(pos, item); });
+            bits &= bits - 1;
+        }
+    }
+}
+
+/**
+ * Columnar export
+ * 
+ * The state lock is held for the whole copy, so the columns are the catalog as
+ * it stood at one moment; an item that a swap, checkout or checkin moves while
+ * the export waits is exported once, where it ended up. The copy is a single
+ * sweep over the occupancy bitmap and the checkout table and is bound by memory
+ * bandwidth, so mutators wait about as long as writing the columns takes.
+ */
+template <typename Geometry, typename Storage>
+CatalogColumns BasicInventory<Geometry, Storage>::exportColumns(CatalogColumns recycled) const {
+    lock_guard guard(stateLock);
+    CatalogColumnsBuilder builder(std::move(recycled));
+    builder.reserve(itemPositions.size() + checkedOutItems.size());
+
+    forEachItem([&](const Position& pos, const auto& item) { builder.add(item, pos); });
+    for (const auto& entry : checkedOutItems) {
+        const CheckoutRecord& info = entry.value;
+        Storage::visit(info.item, [&](const auto& item) {
+            builder.add(item, geometry.positionOf(info.home), true, info.dueDay);
+        });
+    }
+    return std::move(builder).finish();
+}
+
+/**
+ * Secondary index lookups
+ * 
+ * A posting list holds IDs only, so each one is resolved through the position
+ * index, or the checkout table if the item is out. Every indexed ID is in one of
+ * the two, since no item ever leaves the inventory. The names are looked up
+ * without interning them, so searching for an unknown author finds nothing
+ * without growing the symbol table.
+ */
+template <typename Geometry, typename Storage>
+template <typename Keep>
+vector<ItemLocation> BasicInventory<Geometry, Storage>::locate(span<const ItemId> ids, Keep keep) const {
+    vector<ItemLocation> found;
+    found.reserve(ids.size());
+    for (const ItemId id : ids) {
+        if (const Position* pos = itemPositions.find(id)) {
+            if (keep(Storage::get(compartmentAt(*pos)))) found.push_back({id, *pos, false});
+        } else if (const auto* info = checkedOutItems.find(id)) {
+            if (keep(Storage::get(info->item))) found.push_back({id, geometry.positionOf(info->home), true});
+        }
+    }
+    return found;
+}
+
+template <typename Geometry, typename Storage>
+vector<ItemLocation> BasicInventory<Geometry, Storage>::findByAuthor(string_view author) const {
+    lock_guard guard(stateLock);
+    const optional<Symbol> symbol = SymbolTable::find(author);
+    if (!symbol) return {};
+    return locate(itemIndex.byAuthor(*symbol), [](const Item&) { return true; });
+}
+
+template <typename Geometry, typename Storage>
+vector<ItemLocation> BasicInventory<Geometry, Storage>::findByDirector(string_view director) const {
+    lock_guard guard(stateLock);
+    const optional<Symbol> symbol = SymbolTable::find(director);
+    if (!symbol) return {};
+    return locate(itemIndex.byDirector(*symbol), [](const Item&) { return true; });
+}
+
+template <typename Geometry, typename Storage>
+vector<ItemLocation> BasicInventory<Geometry, Storage>::findByActor(string_view actor) const {
+    lock_guard guard(stateLock);
+    const optional<Symbol> symbol = SymbolTable::find(actor);
+    if (!symbol) return {};
+    return locate(itemIndex.byActor(*symbol), [](const Item&) { return true; });
+}
+
+/**
+ * Title lookup
+ * 
+ * The title index is keyed by a hash of the title, so the items it names are
+ * compared against the title to drop the ones that merely share its hash.
+ */
+template <typename Geometry, typename Storage>
+vector<ItemLocation> BasicInventory<Geometry, Storage>::findByTitle(string_view title) const {
+    lock_guard guard(stateLock);
+    return locate(itemIndex.byTitleHash(title), [&](const Item& item) {
+        return withConcreteItem(item, [&]<typename T>(const T& concrete) {
+            if constexpr (is_same_v<T, Item>) return false;
+            else return concrete.getTitle() == title;
+        });
+    });
+}
+
+template <typename Geometry, typename Storage>
+vector<ItemLocation> BasicInventory<Geometry, Storage>::findByCopyrightYear(int year) const {
+    lock_guard guard(stateLock);
+    return locate(itemIndex.byCopyrightYear(year), [](const Item&) { return true; });
+}
+
+template <typename Geometry, typename Storage>
+vector<SearchHit> BasicInventory<Geometry, Storage>::searchText(string_view query, SearchMode mode, size_t limit) const {
+    lock_guard guard(stateLock);
+    const vector<TextMatch> matches = textIndex.search(query, mode, limit);
+    vector<SearchHit> hits;
+    hits.reserve(matches.size());
+    for (const auto& [id, score] : matches) {
+        if (const Position* pos = itemPositions.find(id)) {
+            hits.push_back({{id, *pos, false}, score});
+        } else if (const auto* info = checkedOutItems.find(id)) {
+            hits.push_back({{id, geometry.positionOf(info->home), true}, score});
+        }
+    }
+    return hits;
+}
+
+template <typename Geometry, typename Storage>
+PatronId BasicInventory<Geometry, Storage>::registerPatron(string_view name) {
+    lock_guard guard(stateLock);
+    return patrons.intern(name);
+}
+
+template <typename Geometry, typename Storage>
+optional<PatronId> BasicInventory<Geometry, Storage>::findPatron(string_view name) const {
+    lock_guard guard(stateLock);
+    return patrons.find(name);
+}
+
+template <typename Geometry, typename Storage>
+const string& BasicInventory<Geometry, Storage>::patronName(PatronId patron) const {
+    lock_guard guard(stateLock);
+    checkPatron(patron);
+    return patrons.name(patron);
+}
+
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::setLoanLimit(PatronId patron, uint32_t limit) {
+    lock_guard guard(stateLock);
+    checkPatron(patron);
+    patrons.setLoanLimit(patron, limit);
+}
+
+template <typename Geometry, typename Storage>
+vector<ItemId> BasicInventory<Geometry, Storage>::loansOf(PatronId patron) const {
+    lock_guard guard(stateLock);
+    checkPatron(patron);
+    const span<const ItemId> loans = patrons.loans(patron);
+    return vector<ItemId>(loans.begin(), loans.end());
+}
+
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::checkPatron(PatronId patron) const {
+    if (!patrons.contains(patron)) {
+        throw out_of_range("No patron with ID " + to_string(patron));
+    }
+}
+
+template <typename Geometry, typename Storage>
+vector<DueLoan> BasicInventory<Geometry, Storage>::overdueAsOf(int32_t day) const {
+    if (day == numeric_limits<int32_t>::min()) return {};
+    return dueBetween(numeric_limits<int32_t>::min(), day - 1);
+}
+
+/**
+ * Due date queries
+ * 
+ * The due index yields the IDs already in due order, so the only other work is
+ * one probe into the checkout table per item returned, for its patron and shelf.
+ */
+template <typename Geometry, typename Storage>
+vector<DueLoan> BasicInventory<Geometry, Storage>::dueBetween(int32_t first, int32_t last) const {
+    lock_guard guard(stateLock);
+    vector<DueLoan> loans;
+    dueIndex.forEachDue(first, last, [&](ItemId id, int32_t dueDay) {
+        const CheckoutRecord& info = *checkedOutItems.find(id);
+        loans.push_back({id, dueDay, info.patron, geometry.positionOf(info.home)});
+    });
+    return loans;
+}
+
+/**
+ * Prints all items currently stored in the inventory
+ * 
+ * This method shows how to traverse the entire inventory structure and display
+ * information about each item. The implementation:
+ * 
+ * 1. Uses a flag (foundItems) to track whether any items were found
+ * 2. Iterates through all shelf and compartment positions
+ * 3. Displays item information using the overloaded << operator
+ * 
+ * Using the overloaded << operator from the Item class hierarchy ensures that
+ * each type of item is displayed with its specific properties, demonstrating
+ * polymorphism in action. The foundItems flag provides a better user experience
+ * by showing a "No items" message rather than an empty list.
+ */
+template <typename Geometry, typename Storage>
+ostream& operator<<(ostream& os, const BasicInventory<Geometry, Storage>& inventory) {
+    lock_guard guard(inventory.stateLock);
+    os << "=== Items in Storage ===" << endl;
+
+    bool foundItems = false;
+    // Walk the row-major array once, recovering shelf and compartment from the index
+    const auto* compartment = inventory.shelves.data();
+    for (int i = 0; i < inventory.getShelfCount(); i++) {
+        for (int j = 0; j < inventory.getCompartmentsPerShelf(); j++, compartment++) {
+            if (Storage::occupied(*compartment)) {
+                os << "Shelf: " << i << ", Compartment: " << j << endl;
+                Storage::visit(*compartment, [&os](const auto& item) { os << item << endl; });
+                foundItems = true;
+            }
+        }
+    }
+    
+    if (!foundItems) os << "No items in storage." << endl;
+    return os;
+}
+
+/**
+ * Prints every checked out item
+ * 
+ * One sweep over the checkout table's dense record array, in no particular order.
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::printCheckedOutItems() const {
+    lock_guard guard(stateLock);
+    cout << "=== Checked Out Items ===" << endl;
+    if (checkedOutItems.empty()) {
+        cout << "No items are currently checked out." << endl;
+        return;
+    }
+    
+    for (const auto& entry : checkedOutItems) {
+        printCheckout(entry.key, entry.value);
+    }
+}
+
+/**
+ * Prints one patron's checked out items
+ * 
+ * The patron's own loan list names the records to print, so this costs one
+ * probe into the checkout table per item the patron has out.
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::printCheckedOutItems(PatronId patron) const {
+    lock_guard guard(stateLock);
+    checkPatron(patron);
+    cout << "=== Items Checked Out by " << patrons.name(patron) << " ===" << endl;
+    if (patrons.loans(patron).empty()) {
+        cout << "No items are currently checked out." << endl;
+        return;
+    }
+    for (const ItemId id : patrons.loans(patron)) {
+        printCheckout(id, *checkedOutItems.find(id));
+    }
+}
+
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::printCheckout(ItemId id, const CheckoutRecord& info) const {
+    const Position home = geometry.positionOf(info.home);
+    cout << "Item ID: " << id << endl;
+    Storage::visit(info.item, [](const auto& item) { cout << item << endl; });
+    cout
+    << "Checked out by: " << patrons.name(info.patron) << endl
+    << "Due date: " << formatDate(info.dueDay) << endl
+    << "Original position - Shelf: " << home.getRow()
+    << ", Compartment: " << home.getCol() << endl
+    << "------------------------" << endl;
+}
+
+/**
+ * Snapshot encoding
+ * 
+ * The occupancy words give a shelf's item count without visiting the shelf, so
+ * the count can be written ahead of the items in one pass.
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::encodeShelf(SnapshotWriter& writer, int shelf) const {
+    const int wordsPerShelf = geometry.wordsPerShelf();
+    size_t count = 0;
+    for (int word = 0; word < wordsPerShelf; word++) {
+        count += popcount(occupancy[static_cast<size_t>(shelf) * wordsPerShelf + word]);
+    }
+    count -= static_cast<size_t>(wordsPerShelf) * 64 - geometry.compartmentsPerShelf();
+
+    writer.put<uint32_t>(static_cast<uint32_t>(shelf));
+    writer.put<uint32_t>(static_cast<uint32_t>(count));
+    for (int compartment = 0; compartment < geometry.compartmentsPerShelf(); compartment++) {
+        const Slot& slot = compartmentAt(Position(shelf, compartment));
+        if (Storage::occupied(slot)) {
+            writer.put<uint32_t>(static_cast<uint32_t>(compartment));
+            writer.putItem(Storage::get(slot));
+        }
+    }
+}
+
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::encodeCheckout(SnapshotWriter& writer, const CheckoutRecord& info) const {
+    writer.putString(patrons.name(info.patron));
+    writer.put<int32_t>(info.dueDay);
+    const Position home = geometry.positionOf(info.home);
+    writer.put<int32_t>(home.getRow());
+    writer.put<int32_t>(home.getCol());
+    writer.putItem(Storage::get(info.item));
+}
+
+/**
+ * Snapshot writing
+ * 
+ * Shelves are encoded one at a time into a reusable buffer and streamed out as
+ * length-prefixed blocks, so saving never holds more than one shelf's worth of
+ * encoded bytes. The string dictionary can only be written once every item has
+ * been seen, so it goes last and the header is rewritten with its offset. The
+ * snapshot is written beside its destination, synced and renamed over it at the
+ * end, so a crash mid-save leaves the previous snapshot intact.
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::saveSnapshot(const string& path, ItemId nextId) const {
+    lock_guard serial(checkpointLock);
+    lock_guard guard(stateLock);
+    const string temporary = path + ".tmp";
+    ofstream out(temporary, ios::binary | ios::trunc);
+    if (!out) {
+        throw runtime_error("Cannot write snapshot " + temporary);
+    }
+
+    SnapshotHeader header{geometry.shelfCount(), geometry.compartmentsPerShelf(), nextId, 0,
+                          0, SnapshotKind::Full, static_cast<uint32_t>(geometry.shelfCount())};
+    SnapshotWriter::writeHeader(out, header);
+
+    SnapshotWriter writer;
+    for (int shelf = 0; shelf < geometry.shelfCount(); shelf++) {
+        encodeShelf(writer, shelf);
+        writer.flushBlock(out);
+    }
+
+    // A full snapshot removes no checkout records
+    writer.put<uint32_t>(0);
+    writer.put<uint32_t>(static_cast<uint32_t>(checkedOutItems.size()));
+    for (const auto& entry : checkedOutItems) {
+        encodeCheckout(writer, entry.value);
+    }
+    writer.flushBlock(out);
+
+    header.dictionaryOffset = static_cast<uint64_t>(out.tellp());
+    SnapshotWriter::writeDictionary(out, writer.symbols());
+    out.seekp(0);
+    SnapshotWriter::writeHeader(out, header);
+    out.close();
+    if (!out) {
+        throw runtime_error("Cannot write snapshot " + temporary);
+    }
+    commitFile(temporary, path);
+}
+
+/**
+ * Snapshot loading
+ * 
+ * The base snapshot and then each delta after it are memory-mapped, and every
+ * shelf block is located from the length prefixes alone and checked against its
+ * CRC before anything in it is decoded. The shelves of each
+ * file are then decoded on several threads: each thread owns a contiguous range
+ * of the file's blocks, and with them a disjoint set of shelves, compartments
+ * and occupancy words, so the threads share nothing they write. The pool is not
+ * thread-safe, so each thread allocates from an arena of its own, and the arenas
+ * are spliced into the pool once the load has succeeded. A shelf in a delta
+ * replaces the whole shelf decoded before it, possibly from another thread's
+ * arena, so replaced shelves are emptied on the calling thread before the
+ * threads start. The ID index is filled at the end on the calling thread, grown
+ * once to its final size.
+ * 
+ * Everything is decoded into fresh containers that replace the current ones only
+ * once the whole chain has been read, so a bad file leaves the inventory as it
+ * was.
+ */
+template <typename Geometry, typename Storage>
+ItemId BasicInventory<Geometry, Storage>::loadSnapshot(const string& path) {
+    lock_guard serial(checkpointLock);
+    lock_guard guard(stateLock);
+
+    const MappedFile file(path);
+    const SnapshotHeader header = SnapshotReader::readHeader(file.text());
+    if (header.kind != SnapshotKind::Full) {
+        throw runtime_error(path + " is a checkpoint delta, not a snapshot");
+    }
+
+    Geometry layout = geometry;
+    if constexpr (constructible_from<Geometry, int, int>) {
+        layout = Geometry(header.shelfCount, header.compartmentsPerShelf);
+    } else if (header.shelfCount != geometry.shelfCount() || header.compartmentsPerShelf != geometry.compartmentsPerShelf()) {
+        throw runtime_error("Snapshot shelf layout does not match this inventory");
+    }
+
+    const int shelfCount = layout.shelfCount();
+    const int compartments = layout.compartmentsPerShelf();
+    const int wordsPerShelf = layout.wordsPerShelf();
+    // Bits past the last compartment of a shelf stay set, as markPadding leaves them
+    const uint64_t padding = compartments % 64 != 0 ? ~uint64_t{0} << (compartments % 64) : 0;
+    // One arena per loader thread, declared first so it outlives every slot made from it;
+    // the checkout records, decoded on the calling thread, use the first
+    deque<typename Storage::Arena> arenas(1);
+    vector<Slot> loadedShelves(layout.size());
+    auto loadedOccupancy = layout.makeOccupancyStorage();
+    markPadding(layout, loadedOccupancy);
+    vector<vector<pair<ItemId, int>>> shelfIds(shelfCount);
+    FlatIdMap<CheckoutRecord> loadedCheckouts;
+    // A loan does not know its arena, so if the load fails before the arenas join
+    // the pool, the decoded records hand their items back to it here
+    struct DiscardLoans {
+        FlatIdMap<CheckoutRecord>* records;
+        typename Storage::Arena& arena;
+        ~DiscardLoans() {
+            if (records == nullptr) return;
+            for (auto& entry : *records) Storage::reclaim(arena, entry.value.item);
+        }
+    } discardLoans{&loadedCheckouts, arenas.front()};
+    // Patrons keep their IDs across a load; only their loans are rebuilt
+    PatronRegistry loadedPatrons = patrons;
+    loadedPatrons.clearLoans();
+
+    auto apply = [&](string_view text, const SnapshotHeader& fileHeader) {
+        const vector<Symbol> symbols = SnapshotReader::readDictionary(text, fileHeader);
+        const SnapshotBlocks blocks = SnapshotReader::readBlocks(text, fileHeader);
+
+        auto loadShelves = [&](size_t first, size_t last, typename Storage::Arena& arena) {
+            for (size_t block = first; block < last; block++) {
+                const int shelf = blocks.shelves[block].first;
+                const size_t firstSlot = layout.indexOf(Position(shelf, 0));
+                for (int word = 0; word < wordsPerShelf; word++) {
+                    loadedOccupancy[static_cast<size_t>(shelf) * wordsPerShelf + word] = word + 1 == wordsPerShelf ? padding : 0;
+                }
+
+                SnapshotReader in(blocks.shelves[block].second, symbols);
+                const auto count = in.getCount(sizeof(uint32_t));
+                if (count > static_cast<uint32_t>(compartments)) SnapshotReader::corrupt();
+                auto& ids = shelfIds[shelf];
+                ids.resize(count);
+                for (auto& [id, compartment] : ids) {
+                    const auto column = in.get<uint32_t>();
+                    if (column >= static_cast<uint32_t>(compartments)) SnapshotReader::corrupt();
+                    compartment = static_cast<int>(column);
+
+                    Slot& slot = loadedShelves[firstSlot + compartment];
+                    if (Storage::occupied(slot)) SnapshotReader::corrupt();
+                    slot = in.getItem([&](auto&& item) { return Storage::make(arena, std::move(item)); });
+                    id = Storage::get(slot).getID();
+                    loadedOccupancy[static_cast<size_t>(shelf) * wordsPerShelf + compartment / 64] |= uint64_t{1} << (compartment % 64);
+                }
+                if (!in.atEnd()) SnapshotReader::corrupt();
+            }
+        };
+
+        // Small files are not worth a thread per core
+        const size_t blockCount = blocks.shelves.size();
+        const size_t threads = min<size_t>({
+            max(1u, thread::hardware_concurrency()),
+            max<size_t>(1, blockCount),
+            max<size_t>(1, text.size() >> 20)});
+        for (const auto& [shelf, block] : blocks.shelves) {
+            const size_t firstSlot = layout.indexOf(Position(shelf, 0));
+            for (int compartment = 0; compartment < compartments; compartment++) {
+                loadedShelves[firstSlot + compartment] = Slot();
+            }
+        }
+        while (arenas.size() < threads) arenas.emplace_back();
+        vector<exception_ptr> errors(threads);
+        {
+            vector<jthread> workers;
+            workers.reserve(threads);
+            for (size_t t = 0; t < threads; t++) {
+                auto run = [&, t] {
+                    try {
+                        loadShelves(blockCount * t / threads, blockCount * (t + 1) / threads, arenas[t]);
+                    } catch (...) {
+                        errors[t] = current_exception();
+                    }
+                };
+                if (t + 1 < threads) workers.emplace_back(run);
+                else run();
+            }
+        }
+        for (const exception_ptr& error : errors) {
+            if (error) rethrow_exception(error);
+        }
+
+        SnapshotReader in(blocks.checkouts, symbols);
+        const auto removed = in.getCount(sizeof(int32_t));
+        // A record dropped or replaced by a delta hands its item back to its arena
+        auto discard = [&](ItemId id) {
+            if (CheckoutRecord* old = loadedCheckouts.find(id)) Storage::reclaim(arenas.front(), old->item);
+        };
+        for (uint32_t i = 0; i < removed; i++) {
+            const ItemId id = in.get<int32_t>();
+            discard(id);
+            loadedCheckouts.erase(id);
+        }
+        const auto checkoutCount = in.getCount(sizeof(uint32_t));
+        loadedCheckouts.reserve(loadedCheckouts.size() + checkoutCount);
+        for (uint32_t i = 0; i < checkoutCount; i++) {
+            const PatronId patron = loadedPatrons.intern(in.getString());
+            const int32_t dueDay = in.get<int32_t>();
+            const int row = in.get<int32_t>();
+            const Position pos(row, in.get<int32_t>());
+            if (!layout.isValid(pos)) SnapshotReader::corrupt();
+            Slot slot = in.getItem([&](auto&& item) { return Storage::make(arenas.front(), std::move(item)); });
+            const ItemId id = Storage::get(slot).getID();
+            // A full snapshot holds each record once; a delta may replace an earlier one
+            if (fileHeader.kind == SnapshotKind::Delta) {
+                discard(id);
+            } else if (loadedCheckouts.contains(id)) {
+                throw runtime_error("Snapshot contains item ID " + getStringId(id) + " twice");
+            }
+            loadedCheckouts.insert_or_assign(id, CheckoutRecord(patron, dueDay,
+                static_cast<uint32_t>(layout.indexOf(pos)), Storage::lend(move(slot))));
+        }
+        if (!in.atEnd()) SnapshotReader::corrupt();
+    };
+
+    apply(file.text(), header);
+    CheckpointChain chain{path, header.generation, file.text().size(), 0, 0};
+    ItemId nextId = header.nextId;
+    for (uint64_t generation = header.generation + 1;; generation++) {
+        const string deltaPath = checkpointDeltaPath(path, generation);
+        if (!filesystem::exists(deltaPath)) break;
+        const MappedFile delta(deltaPath);
+        const SnapshotHeader deltaHeader = SnapshotReader::readHeader(delta.text());
+        if (deltaHeader.kind != SnapshotKind::Delta || deltaHeader.generation != generation ||
+            deltaHeader.shelfCount != shelfCount || deltaHeader.compartmentsPerShelf != compartments) {
+            throw runtime_error("Checkpoint " + deltaPath + " does not follow " + path);
+        }
+        apply(delta.text(), deltaHeader);
+        chain.generation = generation;
+        chain.deltaBytes += delta.text().size();
+        chain.deltaCount++;
+        nextId = max(nextId, deltaHeader.nextId);
+    }
+
+    FlatIdMap<Position> loadedPositions;
+    size_t total = 0;
+    for (const auto& ids : shelfIds) total += ids.size();
+    loadedPositions.reserve(total);
+    for (int shelf = 0; shelf < shelfCount; shelf++) {
+        for (const auto& [id, compartment] : shelfIds[shelf]) {
+            if (!loadedPositions.emplace(id, Position(shelf, compartment)).second || loadedCheckouts.contains(id)) {
+                throw runtime_error("Snapshot contains item ID " + getStringId(id) + " twice");
+            }
+        }
+    }
+
+    // The secondary indexes are rebuilt from scratch, shelved and checked-out items alike
+    ItemIndex loadedIndex;
+    TextIndex loadedText;
+    DueIndex loadedDue;
+    TimerWheel<LoanTimer> loadedTimers(loanTimers.now());
+    for (const Slot& slot : loadedShelves) {
+        if (!Storage::occupied(slot)) continue;
+        loadedIndex.add(Storage::get(slot));
+        loadedText.add(Storage::get(slot));
+    }
+    for (auto& entry : loadedCheckouts) {
+        loadedPatrons.addLoan(entry.value.patron, entry.key);
+        loadedIndex.add(Storage::get(entry.value.item));
+        loadedText.add(Storage::get(entry.value.item));
+        loadedDue.add(entry.key, entry.value.dueDay);
+        entry.value.timer = scheduleLoanTimer(loadedTimers, entry.key, entry.value.dueDay);
+    }
+    loadedText.flush();
+
+    // The loaded items join the inventory's pool last; the shelved ones still name their arenas
+    storage.absorb(arenas);
+    for (Slot& slot : loadedShelves) storage.rebind(slot);
+    discardLoans.records = nullptr;
+
+    // Nothing can fail past this point
+    geometry = layout;
+    if constexpr (is_same_v<decltype(shelves), vector<Slot>>) {
+        shelves = std::move(loadedShelves);
+    } else {
+        std::move(loadedShelves.begin(), loadedShelves.end(), shelves.begin());
+    }
+    occupancy = loadedOccupancy;
+    itemPositions = std::move(loadedPositions);
+    // Hand the replaced loans back through the storage, so pooled items return their slots
+    for (auto& entry : checkedOutItems) storage.reclaim(entry.value.item);
+    checkedOutItems = std::move(loadedCheckouts);
+    itemIndex = std::move(loadedIndex);
+    textIndex = std::move(loadedText);
+    dueIndex = std::move(loadedDue);
+    loanTimers = std::move(loadedTimers);
+    patrons = std::move(loadedPatrons);
+
+    // The inventory now matches the chain exactly
+    dirtyShelves.assign((static_cast<size_t>(shelfCount) + 63) / 64, 0);
+    dirtyCheckouts.clear();
+    checkpoints = chain;
+    liveGeneration = chain.generation;
+    return nextId;
+}
+
+/**
+ * Checkpointing
+ * 
+ * Under the state lock the dirty shelves and checkout records are encoded into
+ * memory, the dirty marks are cleared and the journal starts a segment of the new
+ * generation, all in one step: every change logged before the new segment is in
+ * the checkpoint and none after it is. That is the only part that holds up the
+ * mutators. The file is then written and synced without the lock. Only once it
+ * is durable do the inventory and the journal move on to it; if writing fails,
+ * the marks are restored and the journal still holds the records, so the next
+ * attempt, which reuses the same generation, covers everything again.
+ * 
+ * A crash at any point recovers: the loader stops at the last complete delta,
+ * and replay skips exactly the journal segments that delta covers.
+ */
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::checkpoint(const string& path, const CheckpointOptions& options) {
+    lock_guard serial(checkpointLock);
+
+    SnapshotHeader header;
+    vector<char> blocks;
+    vector<Symbol> dictionary;
+    vector<uint64_t> capturedShelves;
+    FlatIdMap<bool> capturedCheckouts;
+    {
+        lock_guard guard(stateLock);
+        const bool full = checkpoints.path != path;
+        header = {geometry.shelfCount(), geometry.compartmentsPerShelf(), options.nextId, 0,
+                  checkpoints.generation + 1, full ? SnapshotKind::Full : SnapshotKind::Delta, 0};
+
+        SnapshotWriter writer;
+        for (int shelf = 0; shelf < geometry.shelfCount(); shelf++) {
+            if (full || (dirtyShelves[shelf / 64] >> (shelf % 64) & 1) != 0) {
+                encodeShelf(writer, shelf);
+                writer.flushBlock(blocks);
+                header.shelfBlocks++;
+            }
+        }
+
+        vector<ItemId> removed;
+        vector<const CheckoutRecord*> records;
+        if (full) {
+            records.reserve(checkedOutItems.size());
+            for (const auto& entry : checkedOutItems) records.push_back(&entry.value);
+        } else {
+            for (const auto& entry : dirtyCheckouts) {
+                if (const auto* info = checkedOutItems.find(entry.key)) records.push_back(info);
+                else removed.push_back(entry.key);
+            }
+        }
+        writer.put<uint32_t>(static_cast<uint32_t>(removed.size()));
+        for (const ItemId id : removed) writer.put<int32_t>(id);
+        writer.put<uint32_t>(static_cast<uint32_t>(records.size()));
+        for (const auto* info : records) encodeCheckout(writer, *info);
+        writer.flushBlock(blocks);
+        dictionary = writer.symbols();
+
+        capturedShelves = exchange(dirtyShelves, vector<uint64_t>(dirtyShelves.size()));
+        capturedCheckouts = exchange(dirtyCheckouts, FlatIdMap<bool>());
+        liveGeneration = header.generation;
+        if (journal) journal->beginGeneration(liveGeneration);
+    }
+
+    const bool full = header.kind == SnapshotKind::Full;
+    const string target = full ? path : checkpointDeltaPath(path, header.generation);
+    uint64_t size = 0;
+    try {
+        // A new base must not pick up deltas left at path by an earlier chain
+        if (full) removeCheckpointDeltas(path);
+
+        const string temporary = target + ".tmp";
+        ofstream out(temporary, ios::binary | ios::trunc);
+        if (!out) {
+            throw runtime_error("Cannot write checkpoint " + temporary);
+        }
+        header.dictionaryOffset = snapshotHeaderSize + blocks.size();
+        SnapshotWriter::writeHeader(out, header);
+        out.write(blocks.data(), static_cast<streamsize>(blocks.size()));
+        SnapshotWriter::writeDictionary(out, dictionary);
+        size = static_cast<uint64_t>(out.tellp());
+        out.close();
+        if (!out) {
+            throw runtime_error("Cannot write checkpoint " + temporary);
+        }
+        commitFile(temporary, target);
+    } catch (...) {
+        lock_guard guard(stateLock);
+        // A snapshot loaded meanwhile replaced the state these marks describe
+        if (capturedShelves.size() == dirtyShelves.size()) {
+            for (size_t word = 0; word < dirtyShelves.size(); word++) dirtyShelves[word] |= capturedShelves[word];
+            for (const auto& entry : capturedCheckouts) markCheckoutDirty(entry.key);
+        }
+        throw;
+    }
+
+    {
+        lock_guard guard(stateLock);
+        if (full) {
+            checkpoints = {path, header.generation, size, 0, 0};
+        } else {
+            checkpoints.generation = header.generation;
+            checkpoints.deltaBytes += size;
+            checkpoints.deltaCount++;
+        }
+        // Held across the rewrite so the journal cannot be detached and destroyed under it
+        if (journal) journal->discardBefore(header.generation);
+    }
+
+    if (!full && (checkpoints.deltaBytes > options.compactionRatio * checkpoints.baseBytes ||
+                  checkpoints.deltaCount >= options.maxDeltas)) {
+        const uint64_t baseBytes = compactCheckpoints(path);
+        lock_guard guard(stateLock);
+        checkpoints.baseBytes = baseBytes;
+        checkpoints.deltaBytes = 0;
+        checkpoints.deltaCount = 0;
+    }
+}
+
+template <typename Geometry, typename Storage>
+void BasicInventory<Geometry, Storage>::attachJournal(Journal* target) {
+    lock_guard guard(stateLock);
+    journal = target;
+    // Its changes follow the state of the last checkpoint captured
+    if (journal) journal->beginGeneration(liveGeneration);
+}
+
+/**
+ * Journal replay
+ * 
+ * Each record is applied through the same code path that produced it, so replay
+ * enforces the same invariants as the original operations; a record that no
+ * longer fits (such as an add into an occupied compartment) means the journal
+ * does not belong on top of this state, and the exception says so. Checkouts are
+ * replayed with their recorded due date rather than one computed today.
+ */
+template <typename Geometry, typename Storage>
+size_t BasicInventory<Geometry, Storage>::replayJournal(const string& path) {
+    lock_guard guard(stateLock);
+    if (journal != nullptr) {
+        throw logic_error("Replay the journal before attaching one");
+    }
+    if (!filesystem::exists(path)) {
+        return 0;
+    }
+
+    const MappedFile file(path);
+    JournalReader reader(file.text(), checkpoints.generation);
+    size_t applied = 0;
+    while (reader.next()) {
+        SnapshotReader in = reader.payload();
+        switch (reader.type()) {
+            case Journal::AddItem: {
+                const int row = in.get<int32_t>();
+                const Position pos(row, in.get<int32_t>());
+                in.getItem([&](auto&& item) { addItem(pos, std::move(item)); });
+                break;
+            }
+            case Journal::Checkout: {
+                const ItemId id = in.get<int32_t>();
+                const string checkedOutBy(in.getString());
+                const int32_t dueDay = in.get<int32_t>();
+                const Position* found = itemPositions.find(id);
+                if (found == nullptr) {
+                    throw runtime_error("Journal checks out item " + getStringId(id) + ", which is not on a shelf");
+                }
+                const Position pos = *found;
+                moveToCheckout(id, pos, patrons.intern(checkedOutBy), dueDay);
+                break;
+            }
+            case Journal::Checkin:
+                checkinItem(in.get<int32_t>());
+                break;
+            case Journal::Renew: {
+                const ItemId id = in.get<int32_t>();
+                extendLoan(id, in.get<int32_t>());
+                break;
+            }
+            case Journal::Swap: {
+                const int row1 = in.get<int32_t>();
+                const Position pos1(row1, in.get<int32_t>());
+                const int row2 = in.get<int32_t>();
+                const Position pos2(row2, in.get<int32_t>());
+                swapItems(pos1, pos2);
+                break;
+            }
+            default:
+                break;
+        }
+        applied++;
+    }
+    return applied;
+}
+
+template <typename Geometry, typename Storage>
+optional<ItemId> BasicInventory<Geometry, Storage>::highestItemId() const {
+    lock_guard guard(stateLock);
+    optional<ItemId> highest;
+    for (const auto& entry : itemPositions) {
+        if (!highest || entry.key > *highest) highest = entry.key;
+    }
+    for (const auto& entry : checkedOutItems) {
+        if (!highest || entry.key > *highest) highest = entry.key;
+    }
+    return highest;
+}
+
+#endif //INVENTORY_TPP
@@ -6,30 +6,49 @@
 #define ITEM_H
 
 #include "project.h"
+#include "SymbolTable.h"
+#include <ranges>
 
 using namespace std;
 
+/// Numeric identifier shared by every item type.
+using ItemId = int;
+
+// Names, authors, directors and actors repeat across a catalog, so they are
+// stored as Symbols into the process-wide SymbolTable rather than as strings.
+// Getters return references into the item or the SymbolTable, so reading a field
+// never allocates; the references stay valid as long as the item does. Interned
+// fields are taken as string_view, so a caller holding a view into a larger buffer
+// (such as the catalog importer) never builds a string just to have it interned.
 class Item {
 protected:
-    string name;
+    Symbol name;
     string description;
     int id;
 
 public:
-    Item(string name, string description, int id) : name(name), description(description), id(id) {}
-
+    Item(string_view name, string description, int id) : name(SymbolTable::intern(name)), description(move(description)), id(id) {}
+    // For callers that have already interned the name
+    Item(Symbol name, string description, int id) : name(name), description(move(description)), id(id) {}
+
+    Item(const Item&) = default;
+    Item(Item&&) = default;
+    Item& operator=(const Item&) = default;
+    Item& operator=(Item&&) = default;
     virtual ~Item() = default;
 
     // Written by Jawad Khadra
     int getID() const {return id;}
-    string getName() const {return name;}
-    string getDescription() const {return description;}
+    const string& getName() const {return SymbolTable::lookup(name);}
+    const string& getDescription() const {return description;}
+    Symbol getNameSymbol() const {return name;}
 
 
-    void print(ostream& os) const {
+    // Virtual so that printing through an Item& shows the details of the actual item type
+    virtual void print(ostream& os) const {
         os
         << "ID: " << id << endl
-        << "Name: " << name << endl
+        << "Name: " << SymbolTable::lookup(name) << endl
         << "Description: " << description << endl;
     }
     friend ostream& operator<<(ostream& os, const Item& item) {
@@ -41,22 +60,24 @@ public:
 class Book : public Item {
 protected:
     string title;
-    string author;
+    Symbol author;
     string copyrightDate;
 
 public:
-    Book(string name, string description, int id, string title, string author, string copyrightDate) : Item(name, description, id), title(title), author(author), copyrightDate(copyrightDate) {}
+    Book(string_view name, string description, int id, string title, string_view author, string copyrightDate) : Item(name, move(description), id), title(move(title)), author(SymbolTable::intern(author)), copyrightDate(move(copyrightDate)) {}
+    Book(Symbol name, string description, int id, string title, Symbol author, string copyrightDate) : Item(name, move(description), id), title(move(title)), author(author), copyrightDate(move(copyrightDate)) {}
 
     // Getters
-    string getTitle() const {return title;}
-    string getAuthor() const { return author;}
-    string getCopyrightDate() const {return copyrightDate;}
+    const string& getTitle() const {return title;}
+    const string& getAuthor() const { return SymbolTable::lookup(author);}
+    const string& getCopyrightDate() const {return copyrightDate;}
+    Symbol getAuthorSymbol() const {return author;}
 
-    void print(ostream& os) const {
+    void print(ostream& os) const override {
         Item::print(os);
         os
         << "Title: " << title << endl
-        << "Author: " << author << endl
+        << "Author: " << SymbolTable::lookup(author) << endl
         << "Copyright Date: " << copyrightDate << endl;
     }
     friend ostream& operator<<(ostream& os, const Book& book) {
@@ -71,12 +92,13 @@ protected:
     string title;
 
     public:
-    Magazine(string name, string description, int id, string edition, string title) : Item(name, description, id), edition(edition), title(title) {}
+    Magazine(string_view name, string description, int id, string edition, string title) : Item(name, move(description), id), edition(move(edition)), title(move(title)) {}
+    Magazine(Symbol name, string description, int id, string edition, string title) : Item(name, move(description), id), edition(move(edition)), title(move(title)) {}
     // Getters
-    string getEdition() const {return edition;}
-    string getTitle() const {return title;}
+    const string& getEdition() const {return edition;}
+    const string& getTitle() const {return title;}
 
-    void print(ostream& os) const {
+    void print(ostream& os) const override {
         Item::print(os);
         os
         << "Edition: " << edition << endl
@@ -91,24 +113,35 @@ protected:
 class Movie : public Item {
     protected:
     string title;
-    string director;
-    vector<string> mainActors;
+    Symbol director;
+    vector<Symbol> mainActors;
 
 public:
-    Movie(string name, string description, int id, string title, string director, vector<string> mainActors) : Item(name, description, id), title(title), director(director), mainActors(mainActors) {}
+    Movie(string_view name, string description, int id, string title, string_view director, const vector<string>& mainActors) : Item(name, move(description), id), title(move(title)), director(SymbolTable::intern(director)) {
+        this->mainActors.reserve(mainActors.size());
+        for (const auto& actor : mainActors) {
+            this->mainActors.push_back(SymbolTable::intern(actor));
+        }
+    }
+    // For callers that have already interned the actors
+    Movie(string_view name, string description, int id, string title, string_view director, vector<Symbol> mainActors) : Item(name, move(description), id), title(move(title)), director(SymbolTable::intern(director)), mainActors(move(mainActors)) {}
+    Movie(Symbol name, string description, int id, string title, Symbol director, vector<Symbol> mainActors) : Item(name, move(description), id), title(move(title)), director(director), mainActors(move(mainActors)) {}
     // Getters
-    string getTitle() const {return title;}
-    string getDirector() const {return director;}
-    vector<string> getMainActors() const {return mainActors;}
-
-    void print(ostream& os) const {
+    const string& getTitle() const {return title;}
+    const string& getDirector() const {return SymbolTable::lookup(director);}
+    // Lazy view yielding const string& for each actor; nothing is copied
+    auto getMainActors() const {return mainActors | views::transform(&SymbolTable::lookup);}
+    Symbol getDirectorSymbol() const {return director;}
+    const vector<Symbol>& getMainActorSymbols() const {return mainActors;}
+
+    void print(ostream& os) const override {
         Item::print(os);
         os
         << "Title: " << title << endl
-        << "Director: " << director << endl
+        << "Director: " << SymbolTable::lookup(director) << endl
         << "Main Actors: " << endl;
         for (auto actor : mainActors) {
-            os << actor << endl;
+            os << SymbolTable::lookup(actor) << endl;
         }
     }
     friend ostream& operator<<(ostream& os, const Movie& movie) {
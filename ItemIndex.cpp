@@ -0,0 +1,144 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "ItemIndex.h"
+#include "ItemStorage.h"
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace std;
+
+namespace {
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+} // namespace
+
+/**
+ * Index keys
+ *
+ * Titles are filed for every type that has one, authors and copyright years for
+ * books, and directors and actors for movies. add and remove both go through
+ * here, so an item is always removed under exactly the keys it was added under.
+ */
+template <typename F>
+void ItemIndex::forEachKey(const Item& item, F&& f) {
+    withConcreteItem(item, [&]<typename T>(const T& concrete) {
+        if constexpr (!is_same_v<T, Item>) {
+            f(titles, hashTitle(concrete.getTitle()));
+        }
+        if constexpr (is_same_v<T, Book>) {
+            f(authors, static_cast<ItemId>(concrete.getAuthorSymbol()));
+            if (const auto year = copyrightYear(concrete.getCopyrightDate())) {
+                f(years, *year);
+            }
+        } else if constexpr (is_same_v<T, Movie>) {
+            f(directors, static_cast<ItemId>(concrete.getDirectorSymbol()));
+            for (const Symbol actor : concrete.getMainActorSymbols()) {
+                f(actors, static_cast<ItemId>(actor));
+            }
+        }
+    });
+}
+
+/**
+ * If a posting list cannot grow part-way through, the postings already made are
+ * taken back, so the caller can treat a failed add as if it never happened.
+ */
+void ItemIndex::add(const Item& item) {
+    const ItemId id = item.getID();
+    try {
+        forEachKey(item, [&](FlatIdMap<int32_t>& index, ItemId key) { insert(index, key, id); });
+    } catch (const bad_alloc&) {
+        remove(item);
+        throw;
+    }
+}
+
+void ItemIndex::remove(const Item& item) {
+    const ItemId id = item.getID();
+    forEachKey(item, [&](FlatIdMap<int32_t>& index, ItemId key) { erase(index, key, id); });
+}
+
+void ItemIndex::clear() {
+    postings.clear();
+    authors.clear();
+    directors.clear();
+    actors.clear();
+    titles.clear();
+    years.clear();
+}
+
+optional<int> ItemIndex::copyrightYear(string_view date) {
+    for (size_t i = 0; i < date.size();) {
+        if (!isDigit(date[i])) {
+            i++;
+            continue;
+        }
+        size_t end = i;
+        while (end < date.size() && isDigit(date[end])) end++;
+        if (end - i == 4) {
+            return (date[i] - '0') * 1000 + (date[i + 1] - '0') * 100 + (date[i + 2] - '0') * 10 + (date[i + 3] - '0');
+        }
+        i = end;
+    }
+    return nullopt;
+}
+
+ItemId ItemIndex::hashTitle(string_view title) {
+    return static_cast<ItemId>(static_cast<uint32_t>(std::hash<string_view>{}(title)));
+}
+
+vector<ItemId> ItemIndex::lookup(const FlatIdMap<int32_t>& index, ItemId key) const {
+    vector<ItemId> ids;
+    const int32_t* newest = index.find(key);
+    for (int32_t at = newest != nullptr ? *newest : -1; at >= 0; at = postings[at].previous) {
+        ids.push_back(postings[at].id);
+    }
+    return ids;
+}
+
+void ItemIndex::insert(FlatIdMap<int32_t>& index, ItemId key, ItemId id) {
+    if (postings.size() > static_cast<size_t>(numeric_limits<int32_t>::max())) {
+        throw length_error("Item index is full");
+    }
+    const auto next = static_cast<int32_t>(postings.size());
+    auto [newest, inserted] = index.emplace(key, next);
+    if (!inserted) {
+        // A movie may list the same actor twice; its postings are made back to back
+        if (postings[*newest].id == id) return;
+        postings.push_back({id, *newest});
+        *newest = next;
+    } else {
+        try {
+            postings.push_back({id, -1});
+        } catch (...) {
+            index.erase(key);
+            throw;
+        }
+    }
+}
+
+/**
+ * Removing a posting
+ *
+ * The posting is unlinked from its key's list and its slot in the shared array
+ * is left unused until clear(). Only a failed insertion removes an item, and
+ * its postings are then the newest of their lists, so the search is short.
+ */
+void ItemIndex::erase(FlatIdMap<int32_t>& index, ItemId key, ItemId id) noexcept {
+    int32_t* newest = index.find(key);
+    if (newest == nullptr) return;
+    for (int32_t* link = newest; *link >= 0; link = &postings[*link].previous) {
+        if (postings[*link].id == id) {
+            *link = postings[*link].previous;
+            if (*newest < 0) index.erase(key);
+            return;
+        }
+    }
+}
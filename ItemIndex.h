@@ -0,0 +1,99 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef ITEMINDEX_H
+#define ITEMINDEX_H
+
+#include "FlatIdMap.h"
+#include "Item.h"
+#include "SymbolTable.h"
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @class ItemIndex
+ * @brief Secondary indexes from authors, directors, actors, titles and copyright
+ *        years to the IDs of the items that have them
+ *
+ * Each index maps a key to a posting list of item IDs. An ID never changes when
+ * its item is swapped, checked out or checked in, so only adding an item changes
+ * the indexes; where the item is now is looked up through the inventory's own ID
+ * indexes. Authors, directors and actors are keyed by Symbol and years by their
+ * number. Titles are not interned, so they are keyed by a 32-bit hash instead of
+ * a copy of the text; a lookup returns every item whose title has that hash, and
+ * the caller compares the titles themselves.
+ *
+ * Adding is the hot path, since every insertion pays it, so the postings of all
+ * keys share one array that only ever grows at the end, each posting linking to
+ * the one before it under the same key. Each index then only maps a key to its
+ * newest posting, small enough to stay in cache for hundreds of thousands of
+ * keys, and an insertion costs one probe and one append instead of a probe into
+ * a per-key list that is somewhere else in memory and reallocates as it grows.
+ */
+class ItemIndex {
+public:
+    /**
+     * @brief Adds item to every index it has a key for
+     * @throws invalid_argument if item is not exactly an Item, Book, Magazine or Movie
+     * @throws bad_alloc if a posting list cannot grow; item is then in no index
+     */
+    void add(const Item& item);
+
+    /// @brief Removes item from every index; an item that was never added is ignored
+    void remove(const Item& item);
+
+    /// @brief Empties every index
+    void clear();
+
+    /// @return IDs of the books by author, newest first
+    vector<ItemId> byAuthor(Symbol author) const { return lookup(authors, static_cast<ItemId>(author)); }
+    /// @return IDs of the movies by director, newest first
+    vector<ItemId> byDirector(Symbol director) const { return lookup(directors, static_cast<ItemId>(director)); }
+    /// @return IDs of the movies actor is in, newest first
+    vector<ItemId> byActor(Symbol actor) const { return lookup(actors, static_cast<ItemId>(actor)); }
+    /// @return IDs of the books copyrighted in year, newest first
+    vector<ItemId> byCopyrightYear(int year) const { return lookup(years, year); }
+
+    /// @return IDs of items whose title hashes like title, a superset of those with exactly this title
+    vector<ItemId> byTitleHash(string_view title) const { return lookup(titles, hashTitle(title)); }
+
+    /**
+     * @brief Extracts the year from a free-form copyright date
+     * @return The first run of exactly four digits, as in "1999", "1999-05-01" or
+     *         "May 1999", or nullopt if there is none
+     */
+    static optional<int> copyrightYear(string_view date);
+
+private:
+    /// One entry of a posting list
+    struct Posting {
+        ItemId id;
+        int32_t previous; ///< Older posting under the same key, or -1
+    };
+
+    /// Postings of every key of every index, in the order they were made
+    vector<Posting> postings;
+
+    /// Newest posting of each key
+    FlatIdMap<int32_t> authors;
+    FlatIdMap<int32_t> directors;
+    FlatIdMap<int32_t> actors;
+    FlatIdMap<int32_t> titles;
+    FlatIdMap<int32_t> years;
+
+    /// @brief Calls f(index, key) for every index item is filed in
+    template <typename F>
+    void forEachKey(const Item& item, F&& f);
+
+    static ItemId hashTitle(string_view title);
+    vector<ItemId> lookup(const FlatIdMap<int32_t>& index, ItemId key) const;
+    void insert(FlatIdMap<int32_t>& index, ItemId key, ItemId id);
+    void erase(FlatIdMap<int32_t>& index, ItemId key, ItemId id) noexcept;
+};
+
+#endif //ITEMINDEX_H
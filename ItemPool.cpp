@@ -0,0 +1,132 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "ItemPool.h"
+#include <algorithm>
+#include <typeinfo>
+
+using namespace std;
+
+SlabArena::SlabArena(size_t slotSize, size_t slotAlign)
+    : slotSize(max(slotSize, sizeof(FreeSlot))), slotAlign(static_cast<align_val_t>(max(slotAlign, alignof(FreeSlot)))) {}
+
+/**
+ * Arena destructor
+ *
+ * Objects still living in the slots have already been destroyed by their owners;
+ * all that is left is handing each slab back to the heap in one call.
+ */
+SlabArena::~SlabArena() {
+    for (byte* slab : slabs) {
+        ::operator delete(slab, slotAlign);
+    }
+}
+
+/**
+ * Slot allocation
+ *
+ * Recycled slots are preferred so a long-running inventory does not grow while
+ * items churn. Otherwise the next untouched slot of the newest slab is used, and
+ * a fresh slab is allocated only when that one is exhausted. Slabs are left
+ * uninitialized because the caller constructs its object in place.
+ */
+void* SlabArena::allocate() {
+    if (freeList) {
+        FreeSlot* slot = freeList;
+        freeList = slot->next;
+        return slot;
+    }
+    if (usedInLastSlab == slotsPerSlab) {
+        slabs.reserve(slabs.size() + 1);
+        slabs.push_back(static_cast<byte*>(::operator new(slotSize * slotsPerSlab, slotAlign)));
+        usedInLastSlab = 0;
+    }
+    return slabs.back() + slotSize * usedInLastSlab++;
+}
+
+void SlabArena::release(void* slot) {
+    freeList = ::new (slot) FreeSlot{freeList};
+}
+
+/**
+ * Splicing
+ *
+ * Only this arena's newest slab is bump-allocated, so the untouched tail of the
+ * other arena's newest slab is threaded onto the free list, and its slabs are
+ * slotted in before that newest slab. The vector insert cannot reallocate, so
+ * once reserve() has been called nothing here can fail.
+ */
+void SlabArena::splice(SlabArena& other) noexcept {
+    if (other.slabs.empty()) return;
+    for (size_t i = other.usedInLastSlab; i < slotsPerSlab; i++) {
+        release(other.slabs.back() + slotSize * i);
+    }
+    while (other.freeList) {
+        FreeSlot* slot = other.freeList;
+        other.freeList = slot->next;
+        release(slot);
+    }
+    slabs.insert(slabs.empty() ? slabs.end() : slabs.end() - 1, other.slabs.begin(), other.slabs.end());
+    other.slabs.clear();
+    other.usedInLastSlab = slotsPerSlab;
+}
+
+ItemPool::ItemPool()
+    : items(sizeof(Item), alignof(Item)),
+      books(sizeof(Book), alignof(Book)),
+      magazines(sizeof(Magazine), alignof(Magazine)),
+      movies(sizeof(Movie), alignof(Movie)) {}
+
+size_t ItemPool::slabCount() const {
+    return items.slabCount() + books.slabCount() + magazines.slabCount() + movies.slabCount();
+}
+
+/**
+ * Every slab list is grown before any is spliced, which is what keeps a failed
+ * splice from leaving some of the other pools taken over and the rest not.
+ */
+void ItemPool::splice(span<ItemPool* const> others) {
+    for (SlabArena ItemPool::*arena : {&ItemPool::items, &ItemPool::books, &ItemPool::magazines, &ItemPool::movies}) {
+        size_t extra = 0;
+        for (const ItemPool* other : others) extra += (other->*arena).slabCount();
+        (this->*arena).reserve(extra);
+    }
+    for (ItemPool* other : others) {
+        items.splice(other->items);
+        books.splice(other->books);
+        magazines.splice(other->magazines);
+        movies.splice(other->movies);
+        live += exchange(other->live, 0);
+    }
+}
+
+/**
+ * Arena lookup by dynamic type
+ *
+ * make() only ever places an object of exactly one of the four known types in a
+ * pooled slot, so the dynamic type identifies the arena the slot came from.
+ */
+SlabArena& ItemPool::arenaFor(const Item& item) {
+    const type_info& type = typeid(item);
+    if (type == typeid(Book)) return books;
+    if (type == typeid(Magazine)) return magazines;
+    if (type == typeid(Movie)) return movies;
+    return items;
+}
+
+/**
+ * Item destruction
+ *
+ * The virtual destructor releases whatever the item owns (its strings and, for
+ * movies, the actor list); the slot itself goes back on its arena's free list.
+ * The slot address is taken from the most-derived object before it is destroyed,
+ * since an Item base subobject is not guaranteed to sit at the start of its slot.
+ */
+void ItemPool::destroy(Item* item) {
+    SlabArena& arena = arenaFor(*item);
+    void* slot = dynamic_cast<void*>(item);
+    item->~Item();
+    arena.release(slot);
+    live--;
+}
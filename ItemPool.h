@@ -0,0 +1,181 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef ITEMPOOL_H
+#define ITEMPOOL_H
+
+#include "Item.h"
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+class ItemPool;
+
+/**
+ * @struct ItemDeleter
+ * @brief Deleter that returns an item to the pool it was created in
+ *
+ * Items that did not come from a pool (pool == nullptr) are deleted normally,
+ * so an ItemPtr can also adopt an item the caller allocated with new.
+ */
+struct ItemDeleter {
+    ItemPool* pool = nullptr; ///< Pool that owns the item's memory, if any
+
+    void operator()(Item* item) const;
+};
+
+/// Owning pointer to an item stored on a shelf or in a checkout record
+using ItemPtr = unique_ptr<Item, ItemDeleter>;
+
+/**
+ * @class SlabArena
+ * @brief Fixed-size slot allocator carving slots out of large slabs
+ *
+ * Allocating slotsPerSlab slots at a time turns one heap allocation per object
+ * into one per slab and keeps objects of the same type packed together. Released
+ * slots are threaded onto an intrusive free list for reuse; the slabs themselves
+ * are only freed, in bulk, when the arena is destroyed.
+ */
+class SlabArena {
+public:
+    /// Number of slots carved out of each slab
+    static constexpr size_t slotsPerSlab = 4096;
+
+    SlabArena(size_t slotSize, size_t slotAlign);
+    ~SlabArena();
+
+    SlabArena(const SlabArena&) = delete;
+    SlabArena& operator=(const SlabArena&) = delete;
+
+    void* allocate();
+    void release(void* slot);
+
+    /**
+     * @brief Makes room for extraSlabs more slabs, so that splice() cannot fail
+     * @throws bad_alloc if the slab list cannot grow
+     */
+    void reserve(size_t extraSlabs) { slabs.reserve(slabs.size() + extraSlabs); }
+
+    /**
+     * @brief Takes over the slabs and free slots of an arena with the same slot size
+     * @param other Arena to empty; reserve(other.slabCount()) must have been called
+     */
+    void splice(SlabArena& other) noexcept;
+
+    /// @return Number of slabs allocated so far
+    size_t slabCount() const { return slabs.size(); }
+
+private:
+    /// Free slots are threaded through their own storage
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+    size_t slotSize;
+    align_val_t slotAlign;
+    vector<byte*> slabs;
+    FreeSlot* freeList = nullptr;
+    size_t usedInLastSlab = slotsPerSlab;
+};
+
+/**
+ * @class ItemPool
+ * @brief Per-type slab allocator for the items held by one inventory
+ *
+ * Each concrete item type (Item, Book, Magazine, Movie) gets its own SlabArena
+ * sized exactly for it, so a catalog's books sit next to each other in memory and
+ * no slot is padded out to the largest type. Item types the pool does not know
+ * about fall back to ordinary new/delete. Destroying the pool frees every slab
+ * at once instead of one allocation per item.
+ *
+ * The pool must outlive every ItemPtr it hands out.
+ */
+class ItemPool {
+public:
+    ItemPool();
+
+    ItemPool(const ItemPool&) = delete;
+    ItemPool& operator=(const ItemPool&) = delete;
+
+    /**
+     * @brief Constructs an item of type T in a pooled slot
+     * @param args Arguments forwarded to T's constructor
+     * @return Owning pointer that returns the slot to this pool on destruction
+     */
+    template <typename T, typename... Args>
+    ItemPtr make(Args&&... args) {
+        static_assert(is_base_of_v<Item, T>, "ItemPool only stores Item types");
+
+        SlabArena* arena = arenaFor<T>();
+        if (arena == nullptr) {
+            return ItemPtr(new T(std::forward<Args>(args)...));
+        }
+
+        void* slot = arena->allocate();
+        try {
+            T* item = ::new (slot) T(std::forward<Args>(args)...);
+            live++;
+            return ItemPtr(item, ItemDeleter{this});
+        } catch (...) {
+            arena->release(slot);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Destroys an item created by make() and recycles its slot
+     * @param item Item to destroy
+     */
+    void destroy(Item* item);
+
+    /**
+     * @brief Takes over the slabs, free slots and live items of other pools
+     * @param others Pools to empty; they may have been filled on other threads
+     * @throws bad_alloc if the slab lists cannot grow, in which case nothing changes
+     * 
+     * The items keep their addresses, but their ItemPtrs still name the pool that
+     * made them; the caller has to point those deleters at this pool.
+     */
+    void splice(span<ItemPool* const> others);
+
+    /// @return Number of pooled items currently alive
+    size_t liveCount() const { return live; }
+
+    /// @return Number of slabs allocated so far across all item types
+    size_t slabCount() const;
+
+private:
+    SlabArena items;
+    SlabArena books;
+    SlabArena magazines;
+    SlabArena movies;
+    size_t live = 0;
+
+    template <typename T>
+    SlabArena* arenaFor() {
+        if constexpr (is_same_v<T, Item>) return &items;
+        else if constexpr (is_same_v<T, Book>) return &books;
+        else if constexpr (is_same_v<T, Magazine>) return &magazines;
+        else if constexpr (is_same_v<T, Movie>) return &movies;
+        else return nullptr;
+    }
+
+    SlabArena& arenaFor(const Item& item);
+};
+
+inline void ItemDeleter::operator()(Item* item) const {
+    if (pool) {
+        pool->destroy(item);
+    } else {
+        delete item;
+    }
+}
+
+#endif //ITEMPOOL_H
@@ -0,0 +1,370 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef ITEMSTORAGE_H
+#define ITEMSTORAGE_H
+
+#include "Item.h"
+#include "ItemPool.h"
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <typeinfo>
+#include <utility>
+#include <variant>
+
+using namespace std;
+
+/**
+ * @brief Calls f with item converted to its exact dynamic type
+ * @param item An Item, by const reference (to copy) or rvalue reference (to move)
+ * @param f Callable taking const Book& / Book&& etc., matching item's value category
+ * @throws invalid_argument if item is not exactly an Item, Book, Magazine or Movie
+ *
+ * This is how the storage policies copy or move an item passed by base reference
+ * without slicing it. Matching the exact type_info (rather than dynamic_cast)
+ * refuses unknown subclasses instead of silently cutting them down to a base.
+ */
+template <typename ItemRef, typename F>
+decltype(auto) withConcreteItem(ItemRef&& item, F&& f) {
+    constexpr bool copying = is_const_v<remove_reference_t<ItemRef>>;
+    auto as = [&]<typename T>() -> decltype(auto) {
+        if constexpr (copying) return std::forward<F>(f)(static_cast<const T&>(item));
+        else return std::forward<F>(f)(static_cast<T&&>(item));
+    };
+
+    const type_info& type = typeid(item);
+    if (type == typeid(Book)) return as.template operator()<Book>();
+    if (type == typeid(Magazine)) return as.template operator()<Magazine>();
+    if (type == typeid(Movie)) return as.template operator()<Movie>();
+    if (type == typeid(Item)) return as.template operator()<Item>();
+    throw invalid_argument("Unsupported item type");
+}
+
+/// A concrete item held by value, as parsers produce them before storage takes over
+using ItemValue = variant<Book, Magazine, Movie>;
+
+/**
+ * @class PooledStorage
+ * @brief Compartments hold owning pointers to items allocated from an ItemPool
+ *
+ * This is the default storage mode. Any Item subclass can be stored, items keep
+ * a stable address for their whole life, and operations dispatch through the
+ * Item class hierarchy. The price is one pointer chase per compartment visited.
+ */
+class PooledStorage {
+private:
+    ItemPool pool;
+
+public:
+    using Slot = ItemPtr;
+
+    /**
+     * @class Loan
+     * @brief Owning handle to a checked-out item, one word instead of an ItemPtr's two
+     *
+     * Every pooled item of an inventory comes from that inventory's pool, so a
+     * checkout record only has to remember whether its item is pooled, and items
+     * are aligned well enough to keep that in the pointer's low bit. lend() packs
+     * a slot into a Loan and reclaim() unpacks it against the pool again.
+     *
+     * A Loan does not know its pool, so a pooled item has to go back through
+     * reclaim(), which destroys it in its pool when the returned slot is dropped;
+     * the inventory does this for every record it still holds when it goes away.
+     * A Loan destroyed while still holding its item only deletes an unpooled one.
+     */
+    class Loan {
+    public:
+        Loan() = default;
+        Loan(Loan&& other) noexcept : bits(exchange(other.bits, 0)) {}
+
+        Loan& operator=(Loan&& other) noexcept {
+            if (this != &other) {
+                reset();
+                bits = exchange(other.bits, 0);
+            }
+            return *this;
+        }
+
+        ~Loan() { reset(); }
+
+        Item* get() const { return reinterpret_cast<Item*>(bits & ~pooledBit); }
+
+    private:
+        friend class PooledStorage;
+        static constexpr uintptr_t pooledBit = 1;
+        static_assert(alignof(Item) > pooledBit, "Item pointers need a free low bit");
+
+        uintptr_t bits = 0;
+
+        Loan(Item* item, bool pooled) : bits(reinterpret_cast<uintptr_t>(item) | (pooled ? pooledBit : 0)) {}
+
+        bool pooled() const { return (bits & pooledBit) != 0; }
+
+        void reset() noexcept {
+            if (!pooled()) delete get();
+            bits = 0;
+        }
+    };
+
+    static bool occupied(const Slot& slot) { return slot != nullptr; }
+    static bool occupied(const Loan& loan) { return loan.get() != nullptr; }
+
+    /// @return true if adopt() can take over item; any item type can be pooled by pointer
+    static bool accepts(const Item&) { return true; }
+
+    /// True for the types emplace() can construct: any Item subclass
+    template <typename T>
+    static constexpr bool holds = derived_from<T, Item>;
+
+    static Item& get(Slot& slot) { return *slot; }
+    static const Item& get(const Slot& slot) { return *slot; }
+    static Item& get(Loan& loan) { return *loan.get(); }
+    static const Item& get(const Loan& loan) { return *loan.get(); }
+
+    /**
+     * @brief Calls f with the item held in slot
+     * @param slot Occupied slot
+     * @param f Callable taking the item; here always as const Item&
+     */
+    template <typename F>
+    static decltype(auto) visit(const Slot& slot, F&& f) { return std::forward<F>(f)(*slot); }
+
+    template <typename F>
+    static decltype(auto) visit(const Loan& loan, F&& f) { return std::forward<F>(f)(*loan.get()); }
+
+    /**
+     * @brief Moves the item in slot into a checkout record's handle
+     * @param slot Slot holding an item of this storage's pool, or an adopted item
+     */
+    static Loan lend(Slot&& slot) {
+        const bool pooled = slot.get_deleter().pool != nullptr;
+        return Loan(slot.release(), pooled);
+    }
+
+    /**
+     * @brief Moves the item of a checkout record back into a slot
+     * @param loan Handle made by lend() on this storage; empty afterwards
+     */
+    Slot reclaim(Loan& loan) { return reclaim(pool, loan); }
+
+    /// Pool a loader thread fills on its own; absorb() later hands its items to the storage
+    using Arena = ItemPool;
+
+    /**
+     * @brief Moves the item of a checkout record whose slot came from arena back into a slot
+     * @param loan Handle made by lend() on a slot of arena; empty afterwards
+     */
+    static Slot reclaim(Arena& arena, Loan& loan) {
+        Item* item = loan.get();
+        const bool pooled = loan.pooled();
+        loan.bits = 0;
+        return Slot(item, ItemDeleter{pooled ? &arena : nullptr});
+    }
+
+    /**
+     * @brief Creates a slot holding a copy of item, or takes over its contents
+     * @param item Item to copy (const reference) or move from (rvalue reference)
+     * 
+     * The new item has the same dynamic type as item, so nothing is sliced.
+     */
+    template <typename ItemRef>
+    Slot make(ItemRef&& item) {
+        return withConcreteItem(std::forward<ItemRef>(item), [this]<typename Source>(Source&& source) {
+            return pool.make<remove_cvref_t<Source>>(std::forward<Source>(source));
+        });
+    }
+
+    /**
+     * @brief Creates a slot owning an item the caller allocated
+     * @param item Heap-allocated item; ownership is taken without copying
+     */
+    static Slot adopt(unique_ptr<Item> item) { return Slot(item.release()); }
+
+    /**
+     * @brief Hands the item in slot back as a heap-allocated object
+     * @param slot Occupied slot; empty afterwards
+     * 
+     * An adopted item is returned as the very object that was adopted.
+     */
+    static unique_ptr<Item> release(Slot& slot) {
+        if (slot.get_deleter().pool == nullptr) return unique_ptr<Item>(slot.release());
+        unique_ptr<Item> item = withConcreteItem(std::move(*slot), []<typename T>(T&& source) -> unique_ptr<Item> {
+            return make_unique<remove_cvref_t<T>>(std::forward<T>(source));
+        });
+        slot.reset();
+        return item;
+    }
+
+    /**
+     * @brief Constructs a T directly in slot
+     * @param slot Empty slot to construct into
+     * @param args Arguments forwarded to T's constructor
+     */
+    template <typename T, typename... Args>
+    void emplace(Slot& slot, Args&&... args) { slot = pool.make<T>(std::forward<Args>(args)...); }
+
+    /**
+     * @brief Creates a slot holding item in arena rather than in the storage's pool
+     * @param arena Arena owned by the calling thread
+     * @param item Concrete item (Book, Magazine, Movie or Item) to move from
+     * 
+     * The pool is not thread-safe, so loaders that build slots on several threads
+     * give each thread an arena of its own and absorb() them all afterwards.
+     */
+    template <typename T>
+    static Slot make(Arena& arena, T&& item) { return arena.make<remove_cvref_t<T>>(std::forward<T>(item)); }
+
+    /**
+     * @brief Takes over the slabs and items of loader arenas
+     * @param arenas Range of Arena; left empty
+     * @throws bad_alloc if the pool cannot grow, in which case nothing changes
+     * 
+     * Slots made from the arenas must then be passed to rebind(); loans need
+     * nothing, since reclaim() already resolves them against the pool.
+     */
+    template <typename Arenas>
+    void absorb(Arenas& arenas) {
+        vector<ItemPool*> others;
+        for (Arena& arena : arenas) others.push_back(&arena);
+        pool.splice(others);
+    }
+
+    /// @brief Points a pooled slot made from an absorbed arena at the storage's pool
+    void rebind(Slot& slot) noexcept {
+        if (slot.get_deleter().pool != nullptr) slot.get_deleter() = ItemDeleter{&pool};
+    }
+};
+
+/**
+ * @class InlineStorage
+ * @brief Compartments hold Book, Magazine and Movie values directly
+ *
+ * Each compartment is a variant stored inline in the contiguous shelves array,
+ * so a full-inventory scan walks memory linearly without a pointer chase or a
+ * virtual call per item; visit() dispatches on the stored type instead.
+ * Only the three concrete item types can be stored. Items move when they are
+ * swapped or checked out, so a pointer to an item is only valid until the next
+ * mutation of the inventory.
+ */
+class InlineStorage {
+public:
+    using Slot = variant<monostate, Book, Magazine, Movie>;
+
+    /// A checked-out item stays the value it was on the shelf
+    using Loan = Slot;
+
+    static Loan lend(Slot&& slot) { return std::move(slot); }
+    static Slot reclaim(Loan& loan) { return exchange(loan, Slot()); }
+
+    static bool occupied(const Slot& slot) { return !holds_alternative<monostate>(slot); }
+
+    /// @return true if item is one of the types a compartment can hold inline
+    static bool accepts(const Item& item) {
+        const type_info& type = typeid(item);
+        return type == typeid(Book) || type == typeid(Magazine) || type == typeid(Movie);
+    }
+
+    /// True for the types emplace() can construct: Book, Magazine and Movie
+    template <typename T>
+    static constexpr bool holds = is_same_v<T, Book> || is_same_v<T, Magazine> || is_same_v<T, Movie>;
+
+    static Item& get(Slot& slot) {
+        switch (slot.index()) {
+            case 1: return *get_if<Book>(&slot);
+            case 2: return *get_if<Magazine>(&slot);
+            case 3: return *get_if<Movie>(&slot);
+            default: throw logic_error("Compartment is empty");
+        }
+    }
+
+    static const Item& get(const Slot& slot) { return get(const_cast<Slot&>(slot)); }
+
+    /**
+     * @brief Calls f with the item held in slot
+     * @param slot Occupied slot
+     * @param f Callable taking the item by its concrete type (const Book&, ...)
+     */
+    template <typename F>
+    static decltype(auto) visit(const Slot& slot, F&& f) {
+        // A switch over the index compiles to a jump table, as std::visit would,
+        // without requiring the callable to accept the empty state
+        switch (slot.index()) {
+            case 1: return std::forward<F>(f)(*get_if<Book>(&slot));
+            case 2: return std::forward<F>(f)(*get_if<Magazine>(&slot));
+            case 3: return std::forward<F>(f)(*get_if<Movie>(&slot));
+            default: throw logic_error("Compartment is empty");
+        }
+    }
+
+    /**
+     * @brief Creates a slot holding a copy of item, or takes over its contents
+     * @param item Item to copy (const reference) or move from (rvalue reference);
+     *             must be a Book, Magazine or Movie
+     * @throws invalid_argument for any other item type
+     */
+    template <typename ItemRef>
+    static Slot make(ItemRef&& item) {
+        return withConcreteItem(std::forward<ItemRef>(item), []<typename Source>(Source&& source) -> Slot {
+            if constexpr (is_same_v<remove_cvref_t<Source>, Item>) {
+                throw invalid_argument("Inline storage only holds books, magazines and movies");
+            } else {
+                return Slot(std::forward<Source>(source));
+            }
+        });
+    }
+
+    /**
+     * @brief Moves the contents of a heap-allocated item into a slot
+     * @param item Item to take over; it is destroyed afterwards
+     */
+    static Slot adopt(unique_ptr<Item> item) { return make(std::move(*item)); }
+
+    /**
+     * @brief Moves the item in slot into a new heap-allocated object
+     * @param slot Occupied slot; empty afterwards
+     */
+    static unique_ptr<Item> release(Slot& slot) {
+        unique_ptr<Item> item = withConcreteItem(std::move(get(slot)), []<typename T>(T&& source) -> unique_ptr<Item> {
+            return make_unique<remove_cvref_t<T>>(std::forward<T>(source));
+        });
+        slot = Slot();
+        return item;
+    }
+
+    /**
+     * @brief Constructs a T directly in slot
+     * @param slot Empty slot to construct into
+     * @param args Arguments forwarded to T's constructor
+     */
+    template <typename T, typename... Args>
+    static void emplace(Slot& slot, Args&&... args) { slot.template emplace<T>(std::forward<Args>(args)...); }
+
+    /// Inline items need no allocator, so a loader thread has nothing of its own to fill
+    struct Arena {};
+
+    static Slot reclaim(Arena&, Loan& loan) { return reclaim(loan); }
+
+    /**
+     * @brief Creates a slot holding item; safe to call from several threads
+     * @param item Concrete item to move from
+     * @throws invalid_argument if item is a plain Item
+     */
+    template <typename T>
+    static Slot make(Arena&, T&& item) {
+        if constexpr (is_same_v<remove_cvref_t<T>, Item>) {
+            throw invalid_argument("Inline storage only holds books, magazines and movies");
+        } else {
+            return Slot(std::forward<T>(item));
+        }
+    }
+
+    template <typename Arenas>
+    static void absorb(Arenas&) {}
+
+    static void rebind(Slot&) noexcept {}
+};
+
+#endif //ITEMSTORAGE_H
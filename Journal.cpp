@@ -0,0 +1,451 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "Journal.h"
+#include "Crc32.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// Each record starts with its length and checksum
+constexpr size_t frameHeaderSize = 2 * sizeof(uint32_t);
+
+// Thin wrappers over the platform's unbuffered file API
+int openForAppend(const string& path) {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+#endif
+}
+
+bool truncateFile(int fd, uint64_t length) {
+#ifdef _WIN32
+    return _chsize_s(fd, static_cast<long long>(length)) == 0;
+#else
+    return ftruncate(fd, static_cast<off_t>(length)) == 0;
+#endif
+}
+
+void closeFile(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+} // namespace
+
+/**
+ * Opening a journal
+ *
+ * A crash can leave a partly written record at the end of the file. Records
+ * appended after it would never be replayed, because replay stops at the first
+ * bad record, so the file is first cut back to its last valid record.
+ */
+Journal::Journal(const string& path, JournalOptions options) : path(path), options(options) {
+    size_t validLength = 0;
+    if (filesystem::exists(path)) {
+        const MappedFile existing(path);
+        JournalReader reader(existing.text());
+        while (reader.next()) {}
+        validLength = reader.validLength();
+        generation = reader.generation();
+    }
+
+    fd = openForAppend(path);
+    if (fd < 0) {
+        throw runtime_error("Cannot open journal " + path);
+    }
+    if (!truncateFile(fd, validLength)) {
+        closeFile(fd);
+        throw runtime_error("Cannot recover journal " + path);
+    }
+    appendedBytes = validLength;
+    durableBytes = validLength;
+
+    beginSegment();
+    if (options.durability != Durability::EveryOperation) {
+        flusher = jthread([this](stop_token stop) { run(stop); });
+    }
+}
+
+Journal::~Journal() {
+    try {
+        flush();
+    } catch (...) {
+        // Nothing more can be done for the records that failed to write
+    }
+    if (flusher.joinable()) {
+        flusher.request_stop();
+        flusher.join();
+    }
+    closeFile(fd);
+}
+
+void Journal::logAdd(const Position& position, const Item& item) {
+    stage(AddItem, [&] {
+        record.put<int32_t>(position.getRow());
+        record.put<int32_t>(position.getCol());
+        record.putItem(item);
+    });
+}
+
+void Journal::logCheckout(ItemId id, const string& checkedOutBy, int32_t dueDay) {
+    stage(Checkout, [&] {
+        record.put<int32_t>(id);
+        record.putString(checkedOutBy);
+        record.put<int32_t>(dueDay);
+    });
+}
+
+void Journal::logCheckin(ItemId id) {
+    stage(Checkin, [&] { record.put<int32_t>(id); });
+}
+
+void Journal::logSwap(const Position& first, const Position& second) {
+    stage(Swap, [&] {
+        record.put<int32_t>(first.getRow());
+        record.put<int32_t>(first.getCol());
+        record.put<int32_t>(second.getRow());
+        record.put<int32_t>(second.getCol());
+    });
+}
+
+void Journal::logRenew(ItemId id, int32_t dueDay) {
+    stage(Renew, [&] {
+        record.put<int32_t>(id);
+        record.put<int32_t>(dueDay);
+    });
+}
+
+/**
+ * Record framing
+ *
+ * The checksum covers the type byte and the payload, so replay can tell a
+ * complete record from one cut short or scribbled over by a crash.
+ */
+void Journal::frame(vector<char>& out, RecordType type, string_view payload) {
+    const auto length = static_cast<uint32_t>(payload.size() + 1);
+    const char typeByte = static_cast<char>(type);
+    const uint32_t checksum = ~crc32Update(crc32Update(~0u, string_view(&typeByte, 1)), payload);
+
+    const size_t at = out.size();
+    out.resize(at + frameHeaderSize + length);
+    memcpy(out.data() + at, &length, sizeof(length));
+    memcpy(out.data() + at + sizeof(length), &checksum, sizeof(checksum));
+    out[at + frameHeaderSize] = typeByte;
+    if (!payload.empty()) memcpy(out.data() + at + frameHeaderSize + 1, payload.data(), payload.size());
+}
+
+/**
+ * Staging a change
+ *
+ * The record is encoded and framed into the staging buffer, preceded by the
+ * definitions of any strings it interned for the first time in this segment.
+ * Everything that can fail happens here, and a failure leaves the buffer as it
+ * was, so the records staged earlier for the same change are kept intact.
+ */
+template <typename Encode>
+void Journal::stage(RecordType type, Encode encode) {
+    unique_lock guard(lock);
+    const size_t start = staged.size();
+    const size_t symbolsBefore = stagedSymbols;
+    try {
+        encode();
+        const vector<Symbol>& dictionary = record.symbols();
+        for (; stagedSymbols < dictionary.size(); stagedSymbols++) {
+            const string& text = SymbolTable::lookup(dictionary[stagedSymbols]);
+            const auto length = static_cast<uint32_t>(text.size());
+            string payload(sizeof(length), '\0');
+            memcpy(payload.data(), &length, sizeof(length));
+            payload += text;
+            frame(staged, DefineSymbol, payload);
+        }
+        frame(staged, type, string_view(record.bytes().data(), record.bytes().size()));
+    } catch (...) {
+        staged.resize(start);
+        stagedSymbols = symbolsBefore;
+        record.clear();
+        throw;
+    }
+    record.clear();
+    stagedRecords++;
+}
+
+/**
+ * Appending a change
+ *
+ * The staged records join the pending group. In EveryOperation mode they are
+ * written and synced before this returns; otherwise the flusher is woken early
+ * if the group is full. The change they describe has already been made, so a
+ * failure here cannot undo it: it is kept, the journal takes no more records,
+ * and the next change or flush() reports it.
+ */
+void Journal::commit() noexcept {
+    unique_lock guard(lock);
+    if (!failure && stagedRecords != 0) {
+        try {
+            pending.insert(pending.end(), staged.begin(), staged.end());
+            appendedBytes += staged.size();
+            symbolsDefined = stagedSymbols;
+            logged += stagedRecords;
+            pendingRecords += stagedRecords;
+
+            if (options.durability == Durability::EveryOperation) {
+                writeOut(pending, true);
+                pending.clear();
+                pendingRecords = 0;
+                durableBytes = appendedBytes;
+            } else if (pendingRecords >= options.groupRecords) {
+                wake.notify_one();
+            }
+        } catch (...) {
+            failure = current_exception();
+        }
+    }
+    staged.clear();
+    stagedRecords = 0;
+    stagedSymbols = symbolsDefined;
+}
+
+void Journal::abandon() noexcept {
+    unique_lock guard(lock);
+    staged.clear();
+    stagedRecords = 0;
+    stagedSymbols = symbolsDefined;
+}
+
+void Journal::beginSegment() {
+    generationStart = appendedBytes;
+    const size_t at = pending.size();
+    frame(pending, BeginSegment, string_view(reinterpret_cast<const char*>(&generation), sizeof(generation)));
+    appendedBytes += pending.size() - at;
+}
+
+void Journal::beginGeneration(uint64_t next) {
+    unique_lock guard(lock);
+    // The new segment starts with an empty dictionary
+    record = SnapshotWriter();
+    symbolsDefined = 0;
+    staged.clear();
+    stagedRecords = 0;
+    stagedSymbols = 0;
+    generation = next;
+    beginSegment();
+}
+
+uint64_t Journal::currentGeneration() const {
+    unique_lock guard(lock);
+    return generation;
+}
+
+void Journal::writeOut(const vector<char>& bytes, bool sync) {
+    size_t written = 0;
+    while (written < bytes.size()) {
+#ifdef _WIN32
+        const auto result = _write(fd, bytes.data() + written, static_cast<unsigned>(bytes.size() - written));
+#else
+        const auto result = write(fd, bytes.data() + written, bytes.size() - written);
+#endif
+        if (result < 0) {
+            throw runtime_error("Cannot write journal");
+        }
+        written += static_cast<size_t>(result);
+    }
+    if (sync && !syncFile(fd)) {
+        throw runtime_error("Cannot sync journal");
+    }
+}
+
+/**
+ * Group commit
+ *
+ * The flusher sleeps until a group fills, a flush is requested or the interval
+ * passes, then takes the whole pending buffer and writes it with the lock
+ * released, so changes keep being logged while the disk is busy. Under
+ * GroupCommit every batch ends with one sync; under Async only an explicit
+ * flush() syncs.
+ */
+void Journal::run(stop_token stop) {
+    unique_lock guard(lock);
+    vector<char> batch;
+    while (true) {
+        wake.wait_for(guard, stop, options.groupInterval, [&] {
+            return flushRequested || pendingRecords >= options.groupRecords;
+        });
+        if (!pending.empty() || flushRequested) {
+            swap(batch, pending);
+            const uint64_t end = appendedBytes;
+            const bool sync = options.durability == Durability::GroupCommit || flushRequested;
+            flushRequested = false;
+            pendingRecords = 0;
+
+            writing = true;
+            guard.unlock();
+            exception_ptr error;
+            try {
+                writeOut(batch, sync);
+            } catch (...) {
+                error = current_exception();
+            }
+            batch.clear();
+            guard.lock();
+            writing = false;
+
+            if (error) {
+                failure = error;
+            } else if (sync) {
+                durableBytes = end;
+            }
+            synced.notify_all();
+        }
+        if (stop.stop_requested() || failure) return;
+    }
+}
+
+void Journal::flush() {
+    unique_lock guard(lock);
+    rethrowFailure();
+    if (options.durability == Durability::EveryOperation) {
+        if (!pending.empty()) {
+            writeOut(pending, true);
+            pending.clear();
+            durableBytes = appendedBytes;
+        }
+        return;
+    }
+    const uint64_t target = appendedBytes;
+    if (durableBytes >= target) return;
+    flushRequested = true;
+    wake.notify_one();
+    synced.wait(guard, [&] { return durableBytes >= target || failure; });
+    rethrowFailure();
+}
+
+/**
+ * Dropping checkpointed segments
+ *
+ * Once no background write is in flight, every framed byte is either in the file
+ * or still pending in memory. The part of the file from the current segment on
+ * is copied to a new file that is synced and renamed over the journal; pending
+ * records are written to it later as usual. The records copied are only those
+ * logged while the checkpoint was being written, so loggers wait briefly.
+ */
+void Journal::discardBefore(uint64_t checkpoint) {
+    unique_lock guard(lock);
+    rethrowFailure();
+    synced.wait(guard, [&] { return !writing; });
+    if (checkpoint != generation || generationStart == droppedBytes) return;
+
+    const uint64_t fileBytes = appendedBytes - pending.size();
+    string kept;
+    if (generationStart < fileBytes) {
+        const MappedFile current(path);
+        kept = string(current.text().substr(generationStart - droppedBytes, fileBytes - generationStart));
+    } else {
+        // Older records may not even have been written yet
+        pending.erase(pending.begin(), pending.begin() + static_cast<ptrdiff_t>(generationStart - fileBytes));
+    }
+
+    const string temporary = path + ".tmp";
+    {
+        ofstream out(temporary, ios::binary | ios::trunc);
+        out.write(kept.data(), static_cast<streamsize>(kept.size()));
+        out.close();
+        if (!out) {
+            throw runtime_error("Cannot write journal " + temporary);
+        }
+    }
+    // Windows cannot rename over a file that is open
+    closeFile(fd);
+    fd = -1;
+    try {
+        commitFile(temporary, path);
+    } catch (...) {
+        reopen();
+        throw;
+    }
+    reopen();
+
+    // The new file was synced, and the records not copied are gone for good
+    durableBytes = max({durableBytes, fileBytes, generationStart});
+    droppedBytes = generationStart;
+}
+
+void Journal::reopen() {
+    fd = openForAppend(path);
+    if (fd < 0) {
+        failure = make_exception_ptr(runtime_error("Cannot reopen journal " + path));
+        rethrowFailure();
+    }
+}
+
+void Journal::throwIfFailed() {
+    unique_lock guard(lock);
+    rethrowFailure();
+}
+
+void Journal::rethrowFailure() {
+    if (failure) rethrow_exception(failure);
+}
+
+bool JournalReader::next() {
+    while (bytes.size() - pos >= frameHeaderSize) {
+        uint32_t length;
+        uint32_t checksum;
+        memcpy(&length, bytes.data() + pos, sizeof(length));
+        memcpy(&checksum, bytes.data() + pos + sizeof(length), sizeof(checksum));
+        if (length == 0 || length > bytes.size() - pos - frameHeaderSize) return false;
+
+        const string_view body = bytes.substr(pos + frameHeaderSize, length);
+        if (crc32(body) != checksum) return false;
+        const auto type = static_cast<Journal::RecordType>(body[0]);
+        const string_view payload = body.substr(1);
+
+        const bool skipped = segmentGeneration < firstGeneration;
+        switch (type) {
+            case Journal::BeginSegment:
+                // A segment header is exactly its generation; anything else is a bad frame
+                if (payload.size() != sizeof(uint64_t)) return false;
+                symbols.clear();
+                segmentGeneration = SnapshotReader(payload).get<uint64_t>();
+                break;
+            case Journal::DefineSymbol:
+                if (!skipped) symbols.push_back(SymbolTable::intern(SnapshotReader(payload).getString()));
+                break;
+            case Journal::AddItem:
+            case Journal::Checkout:
+            case Journal::Checkin:
+            case Journal::Swap:
+            case Journal::Renew:
+                pos += frameHeaderSize + length;
+                if (skipped) continue;
+                currentType = type;
+                currentPayload = payload;
+                return true;
+            default:
+                return false;
+        }
+        pos += frameHeaderSize + length;
+    }
+    return false;
+}
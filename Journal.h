@@ -0,0 +1,261 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "Item.h"
+#include "Position.h"
+#include "Snapshot.h"
+#include "SymbolTable.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/// How long a journaled change may stay in memory before it reaches the disk
+enum class Durability {
+    EveryOperation, ///< Each change is written and synced before the call returns
+    GroupCommit,    ///< Changes are written and synced together every groupInterval or groupRecords
+    Async           ///< Changes are written in the background and synced only by flush()
+};
+
+/**
+ * @struct JournalOptions
+ * @brief Durability mode and group commit thresholds of a Journal
+ */
+struct JournalOptions {
+    Durability durability = Durability::GroupCommit;
+    chrono::milliseconds groupInterval{10}; ///< Longest a pending change waits for a sync
+    size_t groupRecords = 1024;             ///< Pending changes that trigger a sync early
+};
+
+/**
+ * @class Journal
+ * @brief Append-only log of inventory changes, replayed on top of the last snapshot
+ *
+ * Each change is one record framed as (length, CRC-32, type, payload). Items are
+ * encoded as in a snapshot, with interned strings written once per journal
+ * segment as symbol definitions and referenced by index afterwards, so a run of
+ * checkouts by the same patron or of books by one author stays compact.
+ *
+ * Every Journal object starts a new segment, so a process can keep appending to
+ * the journal it replayed at startup. Opening a journal also cuts off a torn
+ * record left at its tail by a crash.
+ *
+ * Each segment is tagged with the checkpoint generation its changes follow.
+ * Replay skips the segments older than the checkpoint it starts from, and once a
+ * checkpoint is durable discardBefore() drops them from the file, so the journal
+ * only ever holds the changes since the last checkpoint or two.
+ *
+ * With GroupCommit and Async the records are buffered and written by a background
+ * thread, so one fsync covers many changes; a crash can lose at most the changes
+ * since the last sync. flush() waits until everything logged so far is durable.
+ *
+ * A change is logged in two steps. The log calls encode and frame its records
+ * before the change is made, so anything that can fail does so while the change
+ * can still be refused; commit() then appends them once the change is made, and
+ * abandon() drops them if it is not. commit() cannot fail: a write error it hits
+ * is kept and thrown by throwIfFailed() and flush() instead.
+ */
+class Journal {
+public:
+    enum RecordType : uint8_t { BeginSegment, DefineSymbol, AddItem, Checkout, Checkin, Swap, Renew };
+
+    /**
+     * @brief Opens or creates the journal at path for appending
+     * @throws runtime_error if the file cannot be opened
+     * 
+     * Logging continues in the generation of the journal's last segment until
+     * beginGeneration is called.
+     */
+    explicit Journal(const string& path, JournalOptions options = {});
+
+    /// Makes every logged change durable, then closes the file
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    /**
+     * @brief Stages the record of a change about to be made, for all log calls
+     * @throws invalid_argument if the item cannot be encoded, bad_alloc; nothing is staged then
+     * 
+     * Records staged since the last commit() or abandon() are appended together.
+     */
+    void logAdd(const Position& position, const Item& item);
+    void logCheckout(ItemId id, const string& checkedOutBy, int32_t dueDay);
+    void logCheckin(ItemId id);
+    void logSwap(const Position& first, const Position& second);
+    void logRenew(ItemId id, int32_t dueDay);
+
+    /**
+     * @brief Appends the staged records, once the changes they describe are made
+     * 
+     * If the journal has failed, or fails now, the records are dropped and the
+     * failure is left for throwIfFailed() and flush() to report.
+     */
+    void commit() noexcept;
+
+    /// @brief Drops the staged records, because their change was not made
+    void abandon() noexcept;
+
+    /// @throws runtime_error if an earlier write failed; nothing is logged after that
+    void throwIfFailed();
+
+    /**
+     * @brief Writes and syncs every change logged so far, waiting until it is durable
+     * @throws runtime_error if writing fails
+     */
+    void flush();
+
+    /**
+     * @brief Starts a segment whose changes follow checkpoint generation
+     * 
+     * Must be called atomically with capturing the state of that checkpoint, so
+     * that every change logged before it is in the checkpoint and none after it is.
+     */
+    void beginGeneration(uint64_t generation);
+
+    /**
+     * @brief Drops every record logged before the current segment
+     * @param generation Checkpoint that has just become durable; nothing is
+     *        dropped unless it is the generation being logged
+     * @throws runtime_error if the journal cannot be rewritten
+     * 
+     * The remaining records are copied to a new file that replaces the journal,
+     * so a crash leaves either the old or the new journal, both of which replay.
+     */
+    void discardBefore(uint64_t generation);
+
+    /// @return Checkpoint generation that changes are being logged in
+    uint64_t currentGeneration() const;
+
+    /// @return Number of change records logged through this object
+    uint64_t recordCount() const { return logged; }
+
+private:
+    int fd = -1;
+    string path;
+    JournalOptions options;
+
+    // Encoder for the record being logged; its dictionary is this segment's symbols
+    SnapshotWriter record;
+    size_t symbolsDefined = 0;
+    uint64_t logged = 0;
+
+    // Framed records waiting for commit(), and the symbols they define. Symbols
+    // interned by abandoned records stay in the dictionary and are defined ahead
+    // of the next record staged instead.
+    vector<char> staged;
+    size_t stagedRecords = 0;
+    size_t stagedSymbols = 0;
+
+    mutable mutex lock;
+    condition_variable_any wake;     // Signals the flusher
+    condition_variable_any synced;   // Signals callers of flush()
+    vector<char> pending;            // Framed records not yet handed to the OS
+    size_t pendingRecords = 0;
+    // Offsets count every byte framed since the journal was opened, including
+    // the ones dropped from the front of the file, so they only ever grow
+    uint64_t appendedBytes = 0;      // Bytes framed so far
+    uint64_t durableBytes = 0;       // Bytes known to be on disk
+    uint64_t droppedBytes = 0;       // Bytes discarded from the front of the file
+    uint64_t generation = 0;         // Generation of the current segment
+    uint64_t generationStart = 0;    // Offset where the current segment begins
+    bool flushRequested = false;
+    bool writing = false;            // The flusher is writing with the lock released
+    exception_ptr failure;
+    jthread flusher;
+
+    static void frame(vector<char>& out, RecordType type, string_view payload);
+    template <typename Encode>
+    void stage(RecordType type, Encode encode);
+    void beginSegment();
+    void reopen();
+    void writeOut(const vector<char>& bytes, bool sync);
+    void run(stop_token stop);
+    void rethrowFailure();
+};
+
+/**
+ * @class StagedChange
+ * @brief Logs a change to a journal only if the change is made
+ *
+ * Created before a change is made, which throws if the journal has already
+ * failed. The records staged while it is alive are appended by commit() and
+ * dropped if it is destroyed first, as when the change throws. A journal of
+ * nullptr logs nothing.
+ */
+class StagedChange {
+public:
+    explicit StagedChange(Journal* journal) : journal(journal) {
+        if (journal) journal->throwIfFailed();
+    }
+
+    ~StagedChange() {
+        if (journal) journal->abandon();
+    }
+
+    StagedChange(const StagedChange&) = delete;
+    StagedChange& operator=(const StagedChange&) = delete;
+
+    /// @brief Appends the records staged so far; call once their change can no longer fail
+    void commit() noexcept {
+        if (journal) journal->commit();
+    }
+
+private:
+    Journal* journal;
+};
+
+/**
+ * @class JournalReader
+ * @brief Iterates over the valid change records of a journal
+ *
+ * Segment and symbol-definition records are consumed internally. Iteration stops
+ * at the end of the file or at the first record that is incomplete or fails its
+ * checksum, which after a crash is the torn tail of the journal.
+ */
+class JournalReader {
+public:
+    /**
+     * @param bytes Contents of the journal
+     * @param firstGeneration Changes in segments of older generations are skipped
+     */
+    explicit JournalReader(string_view bytes, uint64_t firstGeneration = 0)
+        : bytes(bytes), firstGeneration(firstGeneration) {}
+
+    /// @return true if another change record was read
+    bool next();
+
+    Journal::RecordType type() const { return currentType; }
+
+    /// @return Decoder over the current record's payload
+    SnapshotReader payload() const { return SnapshotReader(currentPayload, symbols); }
+
+    /// @return Length of the journal up to the end of the last valid record
+    size_t validLength() const { return pos; }
+
+    /// @return Generation of the segment read last
+    uint64_t generation() const { return segmentGeneration; }
+
+private:
+    string_view bytes;
+    uint64_t firstGeneration;
+    uint64_t segmentGeneration = 0;
+    size_t pos = 0;
+    vector<Symbol> symbols;
+    Journal::RecordType currentType = Journal::BeginSegment;
+    string_view currentPayload;
+};
+
+#endif //JOURNAL_H
@@ -0,0 +1,114 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "MappedFile.h"
+#include <filesystem>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <fstream>
+#include <io.h>
+#include <sstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/**
+ * Mapping
+ *
+ * The whole file is mapped read-only and private. Loaders read it front to back,
+ * which MADV_SEQUENTIAL tells the kernel so it reads ahead aggressively. An empty
+ * file cannot be mapped and simply yields an empty view.
+ */
+MappedFile::MappedFile(const string& path) {
+#ifdef _WIN32
+    ifstream in(path, ios::binary);
+    if (!in) throw runtime_error("Cannot open " + path);
+    stringstream buffer;
+    buffer << in.rdbuf();
+    contents = buffer.str();
+    view = contents;
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("Cannot open " + path);
+    struct stat info {};
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw runtime_error("Cannot read " + path);
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length != 0) {
+        mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("Cannot map " + path);
+        }
+        madvise(mapping, length, MADV_SEQUENTIAL);
+        view = string_view(static_cast<const char*>(mapping), length);
+    }
+    close(fd);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (length != 0) munmap(mapping, length);
+#endif
+}
+
+bool syncFile(int fd) {
+#if defined(_WIN32)
+    return _commit(fd) == 0;
+#elif defined(__APPLE__)
+    // fsync on macOS does not reach the platter; F_FULLFSYNC does
+    return fcntl(fd, F_FULLFSYNC) == 0;
+#else
+    // Only the data has to survive; fdatasync skips the inode times
+    return fdatasync(fd) == 0;
+#endif
+}
+
+/**
+ * Committing a file
+ *
+ * The new file's data is synced before the rename, so the rename can never
+ * expose a file whose blocks have not reached the disk. On POSIX systems the
+ * directory is synced afterwards so the rename itself survives a power loss;
+ * Windows has no equivalent for directories.
+ */
+void commitFile(const string& temporary, const string& path) {
+#ifdef _WIN32
+    const int fd = _open(temporary.c_str(), _O_RDWR | _O_BINARY);
+    const bool synced = fd >= 0 && syncFile(fd);
+    if (fd >= 0) _close(fd);
+#else
+    const int fd = open(temporary.c_str(), O_RDWR);
+    const bool synced = fd >= 0 && syncFile(fd);
+    if (fd >= 0) close(fd);
+#endif
+    if (!synced) {
+        throw runtime_error("Cannot sync " + temporary);
+    }
+
+    error_code error;
+    filesystem::rename(temporary, path, error);
+    if (error) {
+        throw runtime_error("Cannot replace " + path + ": " + error.message());
+    }
+
+#ifndef _WIN32
+    const filesystem::path parent = filesystem::path(path).parent_path();
+    const int directory = open(parent.empty() ? "." : parent.c_str(), O_RDONLY);
+    if (directory >= 0) {
+        fsync(directory);
+        close(directory);
+    }
+#endif
+}
@@ -0,0 +1,66 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+/**
+ * @class MappedFile
+ * @brief Read-only view of a whole file
+ *
+ * The file is memory-mapped rather than read, so loaders work directly on the
+ * page cache: nothing is copied into a user buffer, and pages are faulted in by
+ * whichever thread touches them first. Where mmap is unavailable (Windows) the
+ * file is read into memory instead. The view is valid while the object lives.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Maps the file at path
+     * @throws runtime_error if the file cannot be opened or mapped
+     */
+    explicit MappedFile(const string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// @return The whole contents of the file
+    string_view text() const { return view; }
+
+private:
+    string_view view;
+#ifdef _WIN32
+    string contents;
+#else
+    void* mapping = nullptr;
+    size_t length = 0;
+#endif
+};
+
+/**
+ * @brief Flushes a file's data to stable storage
+ * @param fd Descriptor of the file, open for writing
+ * @return true on success
+ */
+bool syncFile(int fd);
+
+/**
+ * @brief Makes a fully written file durable and moves it over path
+ * @param temporary File written beside path
+ * @param path File to replace
+ * @throws runtime_error if temporary cannot be synced or renamed
+ *
+ * Once this returns, a crash leaves either the old or the new contents at path,
+ * and the new contents survive a power loss.
+ */
+void commitFile(const string& temporary, const string& path);
+
+#endif //MAPPEDFILE_H
@@ -0,0 +1,42 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "PatronRegistry.h"
+#include <algorithm>
+
+using namespace std;
+
+PatronId PatronRegistry::intern(string_view name) {
+    const Symbol symbol = SymbolTable::intern(name);
+    if (const PatronId* found = byName.find(static_cast<ItemId>(symbol))) return *found;
+
+    const auto patron = static_cast<PatronId>(patrons.size());
+    patrons.push_back(Patron{symbol, unlimited, {}});
+    try {
+        byName.emplace(static_cast<ItemId>(symbol), patron);
+    } catch (...) {
+        patrons.pop_back();
+        throw;
+    }
+    return patron;
+}
+
+optional<PatronId> PatronRegistry::find(string_view name) const {
+    const optional<Symbol> symbol = SymbolTable::find(name);
+    if (!symbol) return nullopt;
+    const PatronId* found = byName.find(static_cast<ItemId>(*symbol));
+    return found ? optional<PatronId>(*found) : nullopt;
+}
+
+void PatronRegistry::removeLoan(PatronId patron, ItemId item) noexcept {
+    vector<ItemId>& loans = patrons[patron].loans;
+    const auto loan = std::find(loans.begin(), loans.end(), item);
+    if (loan == loans.end()) return;
+    *loan = loans.back();
+    loans.pop_back();
+}
+
+void PatronRegistry::clearLoans() noexcept {
+    for (Patron& patron : patrons) patron.loans.clear();
+}
@@ -0,0 +1,96 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef PATRONREGISTRY_H
+#define PATRONREGISTRY_H
+
+#include "FlatIdMap.h"
+#include "Item.h"
+#include "SymbolTable.h"
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/// Identifies a registered patron
+using PatronId = int32_t;
+
+/**
+ * @class PatronRegistry
+ * @brief The patrons who have borrowed items, and the items each has out
+ *
+ * Patrons are numbered from 0 in the order they are registered, so a PatronId
+ * indexes straight into an array. Names are interned, and a second index maps a
+ * name's Symbol to its patron. A patron is never removed, so an ID stays valid
+ * for the life of the registry.
+ *
+ * Each patron keeps the IDs of its open loans in a small array of its own, so
+ * listing them or checking them against the patron's loan limit costs the
+ * number of loans that patron has, not the number of items checked out. The
+ * array is unordered: returning a loan moves the last one into its place.
+ */
+class PatronRegistry {
+public:
+    /// Loan limit of a patron who has not been given one
+    static constexpr uint32_t unlimited = numeric_limits<uint32_t>::max();
+
+    /**
+     * @brief Returns the patron called name, registering it first if it is new
+     * @throws bad_alloc if the registry cannot grow; it is then unchanged
+     */
+    PatronId intern(string_view name);
+
+    /// @return The patron called name, or nullopt if there is none
+    optional<PatronId> find(string_view name) const;
+
+    /// @return Whether patron is a registered patron
+    bool contains(PatronId patron) const { return patron >= 0 && static_cast<size_t>(patron) < patrons.size(); }
+
+    /// @return Number of registered patrons
+    size_t size() const { return patrons.size(); }
+
+    /// @return The patron's name; patron must be registered
+    const string& name(PatronId patron) const { return SymbolTable::lookup(patrons[patron].name); }
+
+    /// @return IDs of the items the patron has out, in no particular order
+    span<const ItemId> loans(PatronId patron) const { return patrons[patron].loans; }
+
+    /// @return Most items the patron may have out at once
+    uint32_t loanLimit(PatronId patron) const { return patrons[patron].loanLimit; }
+
+    /// @brief Sets the most items the patron may have out; loans already over it stay
+    void setLoanLimit(PatronId patron, uint32_t limit) { patrons[patron].loanLimit = limit; }
+
+    /// @return Whether the patron has as many items out as the limit allows
+    bool atLoanLimit(PatronId patron) const { return patrons[patron].loans.size() >= patrons[patron].loanLimit; }
+
+    /**
+     * @brief Records that the patron has the item out
+     * @throws bad_alloc if the patron's loans cannot grow; they are then unchanged
+     */
+    void addLoan(PatronId patron, ItemId item) { patrons[patron].loans.push_back(item); }
+
+    /// @brief Records that the patron returned the item; one the patron does not have is ignored
+    void removeLoan(PatronId patron, ItemId item) noexcept;
+
+    /// @brief Forgets every loan, keeping the patrons and their limits
+    void clearLoans() noexcept;
+
+private:
+    struct Patron {
+        Symbol name;
+        uint32_t loanLimit = unlimited;
+        vector<ItemId> loans;
+    };
+
+    vector<Patron> patrons;
+    FlatIdMap<PatronId> byName; ///< Keyed by the name's Symbol
+};
+
+#endif //PATRONREGISTRY_H
@@ -15,20 +15,20 @@ private:
     int col;
     
 public:
-    Position(int row, int col) : row(row), col(col) {}
+    constexpr Position(int row, int col) : row(row), col(col) {}
     
     // Getters
-    int getRow() const { return row; }
-    int getCol() const { return col; }
+    constexpr int getRow() const { return row; }
+    constexpr int getCol() const { return col; }
     
     // Equality operator for comparing positions
-    bool operator==(const Position& other) const {
+    constexpr bool operator==(const Position& other) const {
         return row == other.row && col == other.col;
     }
     
-    // Check if position is valid for a library with 3 shelves and 15 compartments per shelf
-    bool isValid() const {
-        return row >= 0 && row < 3 && col >= 0 && col < 15;
+    // Check if position is valid for a library with the given number of shelves and compartments per shelf
+    constexpr bool isValid(int shelfCount, int compartmentCount) const {
+        return row >= 0 && row < shelfCount && col >= 0 && col < compartmentCount;
     }
 };
 
@@ -0,0 +1,244 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "Snapshot.h"
+#include "Crc32.h"
+#include "ItemStorage.h"
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+constexpr char magic[8] = {'I', 'N', 'V', 'S', 'N', 'A', 'P', '\0'};
+// Reads back as 0x04030201 on a machine of the other byte order
+constexpr uint32_t byteOrderMark = 0x01020304;
+constexpr uint32_t noIndex = UINT32_MAX;
+// Interning fewer strings than this per thread is not worth a thread
+constexpr size_t minimumStringsPerThread = size_t{1} << 16;
+// Nor is checksumming fewer bytes than this
+constexpr size_t minimumBytesPerThread = size_t{1} << 20;
+
+// FNV-1a over the header fields, so a damaged header is rejected before its
+// dimensions are trusted to size any allocation
+uint32_t headerChecksum(const SnapshotHeader& header) {
+    uint32_t hash = 2166136261u;
+    auto mix = [&](uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            hash = (hash ^ static_cast<uint8_t>(value >> (i * 8))) * 16777619u;
+        }
+    };
+    mix(static_cast<uint32_t>(header.shelfCount));
+    mix(static_cast<uint32_t>(header.compartmentsPerShelf));
+    mix(static_cast<uint32_t>(header.nextId));
+    mix(header.dictionaryOffset);
+    mix(header.generation);
+    mix(static_cast<uint32_t>(header.kind));
+    mix(header.shelfBlocks);
+    return hash;
+}
+
+} // namespace
+
+void SnapshotWriter::putString(string_view text) {
+    put<uint32_t>(static_cast<uint32_t>(text.size()));
+    buffer.insert(buffer.end(), text.begin(), text.end());
+}
+
+/**
+ * Symbol encoding
+ *
+ * Symbols are dense, so a flat vector indexed by symbol maps each one to its
+ * dictionary slot in a single load; it only grows to the highest symbol seen.
+ */
+void SnapshotWriter::putSymbol(Symbol symbol) {
+    if (symbol >= localIndex.size()) localIndex.resize(static_cast<size_t>(symbol) + 1, noIndex);
+    uint32_t& index = localIndex[symbol];
+    if (index == noIndex) {
+        index = static_cast<uint32_t>(dictionary.size());
+        dictionary.push_back(symbol);
+    }
+    put<uint32_t>(index);
+}
+
+void SnapshotWriter::putItem(const Item& item) {
+    withConcreteItem(item, [this]<typename T>(const T& concrete) {
+        using Kind = SnapshotReader::Kind;
+        if constexpr (is_same_v<T, Book>) put<uint8_t>(Kind::BookItem);
+        else if constexpr (is_same_v<T, Magazine>) put<uint8_t>(Kind::MagazineItem);
+        else if constexpr (is_same_v<T, Movie>) put<uint8_t>(Kind::MovieItem);
+        else put<uint8_t>(Kind::PlainItem);
+
+        put<int32_t>(concrete.getID());
+        putSymbol(concrete.getNameSymbol());
+        putString(concrete.getDescription());
+        if constexpr (is_same_v<T, Book>) {
+            putString(concrete.getTitle());
+            putSymbol(concrete.getAuthorSymbol());
+            putString(concrete.getCopyrightDate());
+        } else if constexpr (is_same_v<T, Magazine>) {
+            putString(concrete.getEdition());
+            putString(concrete.getTitle());
+        } else if constexpr (is_same_v<T, Movie>) {
+            putString(concrete.getTitle());
+            putSymbol(concrete.getDirectorSymbol());
+            put<uint32_t>(static_cast<uint32_t>(concrete.getMainActorSymbols().size()));
+            for (const Symbol actor : concrete.getMainActorSymbols()) putSymbol(actor);
+        }
+    });
+}
+
+void SnapshotWriter::flushBlock(ostream& out) {
+    const uint64_t length = buffer.size();
+    const uint32_t checksum = crc32(string_view(buffer.data(), buffer.size()));
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+    buffer.clear();
+}
+
+void SnapshotWriter::flushBlock(vector<char>& out) {
+    const uint64_t length = buffer.size();
+    const uint32_t checksum = crc32(string_view(buffer.data(), buffer.size()));
+    const size_t at = out.size();
+    out.resize(at + snapshotBlockPrefixSize);
+    memcpy(out.data() + at, &length, sizeof(length));
+    memcpy(out.data() + at + sizeof(length), &checksum, sizeof(checksum));
+    out.insert(out.end(), buffer.begin(), buffer.end());
+    buffer.clear();
+}
+
+void SnapshotWriter::writeHeader(ostream& out, const SnapshotHeader& header) {
+    SnapshotWriter writer;
+    writer.buffer.insert(writer.buffer.end(), begin(magic), end(magic));
+    writer.put<uint32_t>(snapshotVersion);
+    writer.put<uint32_t>(byteOrderMark);
+    writer.put<int32_t>(header.shelfCount);
+    writer.put<int32_t>(header.compartmentsPerShelf);
+    writer.put<int32_t>(header.nextId);
+    writer.put<uint32_t>(headerChecksum(header));
+    writer.put<uint64_t>(header.dictionaryOffset);
+    writer.put<uint64_t>(header.generation);
+    writer.put<uint32_t>(static_cast<uint32_t>(header.kind));
+    writer.put<uint32_t>(header.shelfBlocks);
+    out.write(writer.buffer.data(), static_cast<streamsize>(writer.buffer.size()));
+}
+
+void SnapshotWriter::writeDictionary(ostream& out, span<const Symbol> symbols) {
+    SnapshotWriter writer;
+    writer.put<uint32_t>(static_cast<uint32_t>(symbols.size()));
+    for (const Symbol symbol : symbols) writer.putString(SymbolTable::lookup(symbol));
+    writer.flushBlock(out);
+}
+
+SnapshotHeader SnapshotReader::readHeader(string_view file) {
+    SnapshotReader in(file);
+    if (in.take(sizeof(magic)) != string_view(magic, sizeof(magic))) {
+        throw runtime_error("Not an inventory snapshot");
+    }
+    if (const auto version = in.get<uint32_t>(); version != snapshotVersion) {
+        throw runtime_error("Unsupported snapshot version " + to_string(version));
+    }
+    if (in.get<uint32_t>() != byteOrderMark) {
+        throw runtime_error("Snapshot was written on a machine with a different byte order");
+    }
+    SnapshotHeader header;
+    header.shelfCount = in.get<int32_t>();
+    header.compartmentsPerShelf = in.get<int32_t>();
+    header.nextId = in.get<int32_t>();
+    const auto checksum = in.get<uint32_t>();
+    header.dictionaryOffset = in.get<uint64_t>();
+    header.generation = in.get<uint64_t>();
+    header.kind = static_cast<SnapshotKind>(in.get<uint32_t>());
+    header.shelfBlocks = in.get<uint32_t>();
+    // Every shelf block has at least a prefix, which bounds a plausible count
+    if (checksum != headerChecksum(header) || header.shelfCount <= 0 || header.compartmentsPerShelf <= 0 ||
+        header.dictionaryOffset > file.size() || header.kind > SnapshotKind::Delta ||
+        header.shelfBlocks > static_cast<uint32_t>(header.shelfCount) ||
+        (header.kind == SnapshotKind::Full && header.shelfBlocks != static_cast<uint32_t>(header.shelfCount)) ||
+        header.shelfBlocks > header.dictionaryOffset / snapshotBlockPrefixSize) {
+        corrupt();
+    }
+    return header;
+}
+
+string_view SnapshotReader::getBlock() {
+    uint32_t checksum;
+    const string_view payload = getFramedBlock(checksum);
+    if (crc32(payload) != checksum) corrupt();
+    return payload;
+}
+
+/**
+ * Block location
+ *
+ * The blocks are found from their prefixes alone, and checksummed in parallel
+ * ranges before the first field of any of them is read. Each block carries its
+ * own checksum, so a loader that decodes shelves on several threads never has
+ * to wait for a checksum over the whole file.
+ */
+SnapshotBlocks SnapshotReader::readBlocks(string_view file, const SnapshotHeader& header) {
+    SnapshotReader in(file.substr(0, header.dictionaryOffset));
+    in.skip(snapshotHeaderSize);
+
+    // The checkout block comes last
+    vector<pair<string_view, uint32_t>> framed(header.shelfBlocks + 1);
+    for (auto& [payload, checksum] : framed) payload = in.getFramedBlock(checksum);
+
+    vector<uint8_t> damaged(framed.size());
+    auto verifyRange = [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) damaged[i] = crc32(framed[i].first) != framed[i].second;
+    };
+    const size_t threads = clamp<size_t>(in.offset() / minimumBytesPerThread, 1,
+                                         min<size_t>(framed.size(), max(1u, thread::hardware_concurrency())));
+    {
+        vector<jthread> workers;
+        for (size_t t = 1; t < threads; t++) {
+            workers.emplace_back(verifyRange, framed.size() * t / threads, framed.size() * (t + 1) / threads);
+        }
+        verifyRange(0, framed.size() / threads);
+    }
+    if (find(damaged.begin(), damaged.end(), 1) != damaged.end()) corrupt();
+
+    SnapshotBlocks blocks;
+    blocks.shelves.reserve(header.shelfBlocks);
+    vector<bool> seen(header.shelfCount);
+    for (uint32_t i = 0; i < header.shelfBlocks; i++) {
+        SnapshotReader block(framed[i].first);
+        const auto shelf = block.get<uint32_t>();
+        if (shelf >= static_cast<uint32_t>(header.shelfCount) || seen[shelf]) corrupt();
+        seen[shelf] = true;
+        blocks.shelves.emplace_back(static_cast<int>(shelf), block.remaining());
+    }
+    blocks.checkouts = framed.back().first;
+    return blocks;
+}
+
+/**
+ * Dictionary loading
+ *
+ * The strings are located in one sequential pass, which only reads their length
+ * prefixes, and then interned in parallel ranges. The SymbolTable is sharded,
+ * so threads interning different strings rarely wait on each other.
+ */
+vector<Symbol> SnapshotReader::readDictionary(string_view file, const SnapshotHeader& header) {
+    SnapshotReader in(SnapshotReader(file.substr(header.dictionaryOffset)).getBlock());
+    vector<string_view> texts(in.getCount(sizeof(uint32_t)));
+    for (string_view& text : texts) text = in.getString();
+
+    vector<Symbol> symbols(texts.size());
+    auto internRange = [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) symbols[i] = SymbolTable::intern(texts[i]);
+    };
+    const size_t threads = clamp<size_t>(texts.size() / minimumStringsPerThread, 1, max(1u, thread::hardware_concurrency()));
+    {
+        vector<jthread> workers;
+        for (size_t t = 1; t < threads; t++) {
+            workers.emplace_back(internRange, texts.size() * t / threads, texts.size() * (t + 1) / threads);
+        }
+        internRange(0, texts.size() / threads);
+    }
+    return symbols;
+}
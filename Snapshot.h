@@ -0,0 +1,266 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "Item.h"
+#include "SymbolTable.h"
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Snapshot file layout (version 4, native byte order, checked on load):
+ *
+ *     header      magic "INVSNAP\0", version, byte-order mark, shelf count,
+ *                 compartments per shelf, next item ID, header checksum,
+ *                 dictionary offset, checkpoint generation, kind, shelf block count
+ *     shelves     one block per shelf stored: shelf index, item count, then
+ *                 (compartment, item)
+ *     checkouts   one block: count and IDs of removed records, then record count
+ *                 and (patron, due day number, position, item)
+ *     dictionary  every interned string the items refer to
+ *
+ * Every block, the dictionary included, is prefixed with its byte length and the
+ * CRC-32 of its bytes. The lengths let a loader find the start of each shelf
+ * without decoding the ones before it and decode them in parallel; the
+ * checksums are verified before anything in a block is decoded, so a damaged
+ * string or number is rejected rather than loaded.
+ * Items refer to interned strings by their index in the dictionary, so a name
+ * shared by many items is stored and re-interned once.
+ *
+ * A full snapshot stores every shelf and checkout record and never removes any.
+ * A delta stores only the shelves and checkout records changed since the
+ * checkpoint one generation earlier, and is applied on top of it.
+ */
+
+/// Format version written by saveSnapshot
+constexpr uint32_t snapshotVersion = 4;
+
+/// Size of the fixed header; the first shelf block starts here
+constexpr size_t snapshotHeaderSize = 56;
+
+/// Size of the length and checksum in front of every block
+constexpr size_t snapshotBlockPrefixSize = sizeof(uint64_t) + sizeof(uint32_t);
+
+/// Whether a snapshot stands alone or applies on top of the previous checkpoint
+enum class SnapshotKind : uint32_t { Full, Delta };
+
+/**
+ * @struct SnapshotHeader
+ * @brief Fixed-size fields at the start of a snapshot
+ */
+struct SnapshotHeader {
+    int shelfCount = 0;
+    int compartmentsPerShelf = 0;
+    ItemId nextId = 0;              ///< Next unused item ID, as kept by the caller
+    uint64_t dictionaryOffset = 0;  ///< File offset of the string dictionary
+    uint64_t generation = 0;        ///< Checkpoint generation the snapshot captures
+    SnapshotKind kind = SnapshotKind::Full;
+    uint32_t shelfBlocks = 0;       ///< Number of shelf blocks that follow the header
+};
+
+/**
+ * @struct SnapshotBlocks
+ * @brief Where a snapshot's blocks lie, found from their length prefixes alone
+ */
+struct SnapshotBlocks {
+    vector<pair<int, string_view>> shelves; ///< Shelf index and the rest of its block
+    string_view checkouts;                  ///< The checkout block
+};
+
+/**
+ * @class SnapshotWriter
+ * @brief Encodes snapshot blocks into a reusable byte buffer
+ *
+ * Symbols are written as indexes into the snapshot's own dictionary, which the
+ * writer grows as new symbols appear; symbols() returns it in index order.
+ */
+class SnapshotWriter {
+public:
+    template <typename T>
+    void put(T value) {
+        static_assert(is_trivially_copyable_v<T>);
+        const size_t at = buffer.size();
+        buffer.resize(at + sizeof(T));
+        memcpy(buffer.data() + at, &value, sizeof(T));
+    }
+
+    void putString(string_view text);
+    void putSymbol(Symbol symbol);
+
+    /**
+     * @brief Encodes an item with its exact type
+     * @throws invalid_argument if item is not an Item, Book, Magazine or Movie
+     */
+    void putItem(const Item& item);
+
+    /// @brief Writes the buffered bytes as one checksummed block and empties the buffer
+    void flushBlock(ostream& out);
+
+    /// @brief Appends the buffered bytes as one checksummed block and empties the buffer
+    void flushBlock(vector<char>& out);
+
+    /// @return Bytes encoded since the last flushBlock or clear
+    const vector<char>& bytes() const { return buffer; }
+
+    /// @brief Discards the buffered bytes, keeping the dictionary
+    void clear() { buffer.clear(); }
+
+    /// @return Dictionary of the symbols written so far, in index order
+    const vector<Symbol>& symbols() const { return dictionary; }
+
+    static void writeHeader(ostream& out, const SnapshotHeader& header);
+    static void writeDictionary(ostream& out, span<const Symbol> symbols);
+
+private:
+    vector<char> buffer;
+    vector<uint32_t> localIndex;  // Symbol -> dictionary index, or noIndex
+    vector<Symbol> dictionary;
+};
+
+/**
+ * @class SnapshotReader
+ * @brief Bounds-checked decoder over part of a snapshot
+ *
+ * Every read checks the remaining length and throws runtime_error on a truncated
+ * or corrupt snapshot rather than reading past the end of the file.
+ */
+class SnapshotReader {
+public:
+    /// Kinds of item record; stored as the first byte of each item
+    enum Kind : uint8_t { PlainItem, BookItem, MagazineItem, MovieItem };
+
+    explicit SnapshotReader(string_view bytes, span<const Symbol> symbols = {}) : bytes(bytes), symbols(symbols) {}
+
+    bool atEnd() const { return pos == bytes.size(); }
+    void skip(size_t count) { take(count); }
+
+    /// @return Bytes consumed so far
+    size_t offset() const { return pos; }
+
+    /// @return The bytes not yet consumed
+    string_view remaining() const { return bytes.substr(pos); }
+
+    template <typename T>
+    T get() {
+        static_assert(is_trivially_copyable_v<T>);
+        T value;
+        memcpy(&value, take(sizeof(T)).data(), sizeof(T));
+        return value;
+    }
+
+    string_view getString() { return take(get<uint32_t>()); }
+
+    /**
+     * @brief Reads an element count, checked against the bytes that remain
+     * @param minimumBytesEach Smallest encoded size of one element
+     * 
+     * Keeps a damaged count from sizing a huge allocation before the elements
+     * themselves would have run off the end.
+     */
+    uint32_t getCount(size_t minimumBytesEach) {
+        const auto count = get<uint32_t>();
+        if (count > (bytes.size() - pos) / minimumBytesEach) corrupt();
+        return count;
+    }
+
+    Symbol getSymbol() {
+        const auto index = get<uint32_t>();
+        if (index >= symbols.size()) corrupt();
+        return symbols[index];
+    }
+
+    /**
+     * @brief Reads the next block
+     * @return Its payload, once its checksum has been verified
+     */
+    string_view getBlock();
+
+    /**
+     * @brief Decodes the next item and passes it to f by its concrete type
+     * @param f Callable taking Book&&, Magazine&&, Movie&& or Item&&
+     */
+    template <typename F>
+    decltype(auto) getItem(F&& f) {
+        const auto kind = get<uint8_t>();
+        const auto id = get<int32_t>();
+        const Symbol name = getSymbol();
+        string description(getString());
+        switch (kind) {
+            case BookItem: {
+                string title(getString());
+                const Symbol author = getSymbol();
+                return std::forward<F>(f)(Book(name, move(description), id, move(title), author, string(getString())));
+            }
+            case MagazineItem: {
+                string edition(getString());
+                return std::forward<F>(f)(Magazine(name, move(description), id, move(edition), string(getString())));
+            }
+            case MovieItem: {
+                string title(getString());
+                const Symbol director = getSymbol();
+                vector<Symbol> actors(getCount(sizeof(uint32_t)));
+                for (Symbol& actor : actors) actor = getSymbol();
+                return std::forward<F>(f)(Movie(name, move(description), id, move(title), director, move(actors)));
+            }
+            case PlainItem:
+                return std::forward<F>(f)(Item(name, move(description), id));
+            default:
+                corrupt();
+        }
+    }
+
+    static SnapshotHeader readHeader(string_view file);
+
+    /**
+     * @brief Locates and verifies the shelf and checkout blocks of a snapshot
+     * @throws runtime_error if a block runs past the dictionary, fails its
+     *         checksum, or has a shelf index that is out of range or repeated
+     *
+     * Large snapshots have their blocks verified on several threads.
+     */
+    static SnapshotBlocks readBlocks(string_view file, const SnapshotHeader& header);
+
+    /**
+     * @brief Re-interns the dictionary stored at the header's offset
+     * @return Symbol for each dictionary index in this process
+     *
+     * Large dictionaries are interned on several threads.
+     */
+    static vector<Symbol> readDictionary(string_view file, const SnapshotHeader& header);
+
+    [[noreturn]] static void corrupt() { throw runtime_error("Snapshot is truncated or corrupt"); }
+
+private:
+    string_view bytes;
+    span<const Symbol> symbols;
+    size_t pos = 0;
+
+    /// @brief Reads the next block's checksum and payload without verifying them
+    string_view getFramedBlock(uint32_t& checksum) {
+        const auto length = get<uint64_t>();
+        checksum = get<uint32_t>();
+        return take(length);
+    }
+
+    string_view take(size_t count) {
+        if (count > bytes.size() - pos) corrupt();
+        const string_view out = bytes.substr(pos, count);
+        pos += count;
+        return out;
+    }
+};
+
+#endif //SNAPSHOT_H
@@ -0,0 +1,151 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "SymbolTable.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// 4096 strings per chunk and 2^20 chunk slots cover the whole 32-bit symbol space.
+// The chunk directory is zero-initialized static storage, so untouched slots cost
+// no resident memory.
+constexpr unsigned chunkBits = 12;
+constexpr size_t chunkSize = size_t{1} << chunkBits;
+constexpr size_t maxChunks = size_t{1} << (32 - chunkBits);
+
+// Strings are spread over independently locked shards by the top bits of their
+// hash, so threads interning different strings rarely wait on each other
+constexpr unsigned shardBits = 6;
+constexpr size_t shardCount = size_t{1} << shardBits;
+constexpr size_t initialShardSlots = 1024;
+
+atomic<string*> chunks[maxChunks];
+
+string& textOf(size_t symbol) {
+    return chunks[symbol >> chunkBits].load(memory_order_acquire)[symbol & (chunkSize - 1)];
+}
+
+/**
+ * One shard of the intern index
+ *
+ * An open-addressing table of (hash, symbol) pairs. Probing compares the stored
+ * hash first, so the string itself is only read on a likely match; a lookup of a
+ * new string usually touches a single cache line of the table. Symbol 0 (the
+ * empty string) is never stored, which lets it mark an empty slot.
+ */
+struct Shard {
+    struct Slot {
+        uint32_t hash = 0;
+        Symbol symbol = SymbolTable::empty;
+    };
+
+    mutex lock;
+    vector<Slot> slots = vector<Slot>(initialShardSlots);
+    size_t used = 0;
+
+    Slot& probe(uint32_t hash, string_view text) {
+        const size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            Slot& slot = slots[i];
+            if (slot.symbol == SymbolTable::empty) return slot;
+            if (slot.hash == hash && textOf(slot.symbol) == text) return slot;
+        }
+    }
+
+    void grow() {
+        vector<Slot> old(slots.size() * 2);
+        swap(old, slots);
+        const size_t mask = slots.size() - 1;
+        for (const Slot& slot : old) {
+            if (slot.symbol == SymbolTable::empty) continue;
+            size_t i = slot.hash & mask;
+            while (slots[i].symbol != SymbolTable::empty) i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+    }
+};
+
+struct State {
+    // Symbol 0 is the empty string, which the first chunk holds from the start
+    atomic<size_t> count{1};
+    Shard shards[shardCount];
+
+    State() { chunks[0].store(new string[chunkSize], memory_order_release); }
+
+    // Called with the shard's lock held
+    Symbol insert(Shard& shard, Shard::Slot& slot, uint32_t hash, string_view text) {
+        const size_t symbol = count.fetch_add(1, memory_order_relaxed);
+        if (symbol >= chunkSize * maxChunks) throw length_error("Symbol table is full");
+
+        // Two shards may need the same new chunk at once; the loser frees its copy
+        atomic<string*>& chunk = chunks[symbol >> chunkBits];
+        if (chunk.load(memory_order_acquire) == nullptr) {
+            string* fresh = new string[chunkSize];
+            string* expected = nullptr;
+            if (!chunk.compare_exchange_strong(expected, fresh, memory_order_acq_rel)) delete[] fresh;
+        }
+        textOf(symbol).assign(text);
+
+        slot = {hash, static_cast<Symbol>(symbol)};
+        if (++shard.used * 4 > shard.slots.size() * 3) shard.grow();
+        return static_cast<Symbol>(symbol);
+    }
+};
+
+State& state() {
+    static State instance;
+    return instance;
+}
+
+} // namespace
+
+/**
+ * Interning
+ *
+ * The common case for a catalog is a repeat (the same author on many books), so
+ * the lookup happens before any allocation; only a genuinely new string is copied
+ * into the table. Only the shard owning the string's hash is locked.
+ */
+Symbol SymbolTable::intern(string_view text) {
+    if (text.empty()) return empty;
+    State& s = state();
+    const size_t hash = std::hash<string_view>{}(text);
+    Shard& shard = s.shards[static_cast<uint64_t>(hash) >> (64 - shardBits)];
+    lock_guard lock(shard.lock);
+    Shard::Slot& slot = shard.probe(static_cast<uint32_t>(hash), text);
+    if (slot.symbol != empty) return slot.symbol;
+    return s.insert(shard, slot, static_cast<uint32_t>(hash), text);
+}
+
+optional<Symbol> SymbolTable::find(string_view text) {
+    if (text.empty()) return empty;
+    State& s = state();
+    const size_t hash = std::hash<string_view>{}(text);
+    Shard& shard = s.shards[static_cast<uint64_t>(hash) >> (64 - shardBits)];
+    lock_guard lock(shard.lock);
+    const Shard::Slot& slot = shard.probe(static_cast<uint32_t>(hash), text);
+    if (slot.symbol != empty) return slot.symbol;
+    return nullopt;
+}
+
+/**
+ * Lock-free lookup
+ *
+ * A symbol can only be held by someone who received it from intern(), after its
+ * chunk was published, so the acquire load always sees a complete chunk.
+ */
+const string& SymbolTable::lookup(Symbol symbol) {
+    state();
+    return textOf(symbol);
+}
+
+size_t SymbolTable::size() {
+    return state().count.load(memory_order_acquire);
+}
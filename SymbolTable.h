@@ -0,0 +1,65 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+/// Compact handle for an interned string
+using Symbol = uint32_t;
+
+/**
+ * @class SymbolTable
+ * @brief Process-wide intern pool for names, authors, directors and actors
+ *
+ * Each distinct string is stored exactly once and identified by a Symbol, so
+ * items that share an author or actor share one copy of the text and compare
+ * equal with a single integer comparison. Interned strings are never freed or
+ * moved; a reference returned by lookup() stays valid for the life of the process.
+ *
+ * Interning locks only the one of several shards that the string hashes to, so
+ * concurrent loaders rarely contend. Lookup takes no lock: strings live in
+ * fixed-size chunks whose addresses never change once published, so a reader
+ * holding a Symbol can always reach its string.
+ */
+class SymbolTable {
+public:
+    /// Symbol of the empty string, which is always interned
+    static constexpr Symbol empty = 0;
+
+    /**
+     * @brief Interns text, returning the existing symbol if it was seen before
+     * @param text String to intern
+     * @return Symbol identifying text
+     */
+    static Symbol intern(string_view text);
+
+    /**
+     * @brief Finds the symbol of text without interning it
+     * @param text String to look for
+     * @return Its symbol, or nullopt if text has never been interned
+     *
+     * Searches use this so that querying for an unknown author does not grow the table.
+     */
+    static optional<Symbol> find(string_view text);
+
+    /**
+     * @brief Returns the text of an interned string
+     * @param symbol Symbol previously returned by intern()
+     * @return Reference to the interned text, valid for the life of the process
+     */
+    static const string& lookup(Symbol symbol);
+
+    /// @return Number of distinct strings interned so far
+    static size_t size();
+};
+
+#endif //SYMBOLTABLE_H
@@ -0,0 +1,595 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "TextIndex.h"
+#include "ItemStorage.h"
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+using namespace std;
+
+namespace {
+
+constexpr uint32_t blockSize = 64;
+
+/// Longest varint of a 64-bit value
+constexpr size_t maxVarintBytes = 10;
+
+/// Size the term table starts at once the first term is added
+constexpr size_t minimumTermSlots = 1024;
+
+/// A clause over more lists than this is not bounded, as adding up their blocks costs more than it saves
+constexpr size_t maxBoundedLists = 16;
+
+size_t putVarint(uint8_t* out, uint64_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = static_cast<uint8_t>(value);
+    return length;
+}
+
+uint64_t getVarint(const uint8_t*& at) {
+    uint64_t value = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        const uint8_t byte = *at++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) return value;
+    }
+}
+
+uint32_t hashTerm(string_view term) {
+    return static_cast<uint32_t>(std::hash<string_view>{}(term));
+}
+
+bool isWordByte(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+/**
+ * One query term, as the union of the posting lists of the terms it matches
+ *
+ * The cursors are kept in a min-heap on their keys, so the union is read in key
+ * order however many terms a prefix expands to. An exact term has one cursor,
+ * which is read directly.
+ */
+class Clause {
+public:
+    void add(const PostingList& list) {
+        heap.push_back(static_cast<uint32_t>(cursors.size()));
+        cursors.emplace_back(list);
+        cost += list.size();
+    }
+
+    bool empty() const { return cursors.empty(); }
+    size_t size() const { return cost; }
+
+    /// @return Whether boundFrom may be called
+    bool bounded() const { return cursors.size() <= maxBoundedLists; }
+
+    /// @brief Orders the cursors; call once every list has been added
+    void start() {
+        erase_if(heap, [&](uint32_t i) { return !cursors[i].valid(); });
+        make_heap(heap.begin(), heap.end(), later());
+    }
+
+    bool valid() const { return !heap.empty(); }
+    uint32_t key() const { return cursors[heap.front()].key(); }
+
+    /// @brief Moves every cursor forward to the first key of at least target
+    void seek(uint32_t target) {
+        if (heap.size() == 1) {
+            cursors[heap.front()].seek(target);
+            if (!cursors[heap.front()].valid()) heap.clear();
+            return;
+        }
+        while (!heap.empty() && key() < target) {
+            pop_heap(heap.begin(), heap.end(), later());
+            PostingList::Cursor& cursor = cursors[heap.back()];
+            cursor.seek(target);
+            restore(cursor);
+        }
+    }
+
+    /// @return Frequency of the current key summed over every term, after which the clause moves past it
+    uint32_t take() {
+        if (heap.size() == 1) {
+            PostingList::Cursor& cursor = cursors[heap.front()];
+            const uint32_t frequency = cursor.frequency();
+            cursor.next();
+            if (!cursor.valid()) heap.clear();
+            return frequency;
+        }
+        const uint32_t at = key();
+        uint32_t frequency = 0;
+        while (!heap.empty() && key() == at) {
+            pop_heap(heap.begin(), heap.end(), later());
+            PostingList::Cursor& cursor = cursors[heap.back()];
+            frequency += cursor.frequency();
+            cursor.next();
+            restore(cursor);
+        }
+        return frequency;
+    }
+
+    /**
+     * @brief Bounds the frequency of the keys from target on
+     * @return The highest frequency any key in [target, last] can have, and last
+     *
+     * A cursor already past target has no keys before its own, and its block
+     * covers those from its own key to the end of the block.
+     */
+    PostingList::BlockBound boundFrom(uint32_t target) {
+        uint32_t bound = 0;
+        uint32_t last = numeric_limits<uint32_t>::max();
+        for (const uint32_t i : heap) {
+            const auto block = cursors[i].boundFrom(max(target, cursors[i].key()));
+            bound += block.maxFrequency;
+            last = min(last, block.last);
+        }
+        return {bound, last};
+    }
+
+private:
+    vector<PostingList::Cursor> cursors;
+    vector<uint32_t> heap;
+    size_t cost = 0;
+
+    /// Heap order that puts the cursor with the smallest key at the front
+    struct Later {
+        const Clause* clause;
+        bool operator()(uint32_t a, uint32_t b) const { return clause->cursors[a].key() > clause->cursors[b].key(); }
+    };
+    Later later() const { return {this}; }
+
+    /// Puts the cursor at the back of the heap back in place, or drops it if it is finished
+    void restore(const PostingList::Cursor& cursor) {
+        if (cursor.valid()) {
+            push_heap(heap.begin(), heap.end(), later());
+        } else {
+            heap.pop_back();
+        }
+    }
+};
+
+} // namespace
+
+void PostingList::add(uint32_t key, uint32_t frequency) {
+    if (count == 0 || key > last) {
+        append(key, frequency);
+        return;
+    }
+    pending.push_back({key, frequency});
+    if (pending.size() >= max<size_t>(blockSize, count / 4)) flush();
+}
+
+/**
+ * Removing an item
+ *
+ * Deltas depend on the posting before them, so the list is decoded from the
+ * start of the block holding key and encoded again from there without it. Only
+ * a failed insertion removes an item, and its postings are at the end of their
+ * lists or still pending, so this touches a block or two. The shorter tail fits
+ * in the memory the old one used, so encoding it cannot fail.
+ */
+void PostingList::remove(uint32_t key) {
+    const auto waiting = find_if(pending.begin(), pending.end(), [&](const Posting& p) { return p.key == key; });
+    if (waiting != pending.end()) {
+        *waiting = pending.back();
+        pending.pop_back();
+        return;
+    }
+    if (count == 0) return;
+    const uint32_t block = blockOf(key);
+    vector<Posting> tail;
+    for (Cursor cursor(*this, block); cursor.valid(); cursor.next()) {
+        tail.push_back({cursor.key(), cursor.frequency()});
+    }
+    const auto at = lower_bound(tail.begin(), tail.end(), key, [](const Posting& p, uint32_t k) { return p.key < k; });
+    if (at == tail.end() || at->key != key) return;
+    tail.erase(at);
+
+    bytes.resize(blocks[block].offset);
+    last = blocks[block].before;
+    blocks.resize(block);
+    count = block * blockSize;
+    lastMaxFrequency = block != 0 ? blocks[block - 1].maxFrequency : 0;
+    for (const Posting& posting : tail) {
+        append(posting.key, posting.frequency);
+    }
+}
+
+void PostingList::flush() {
+    if (pending.empty()) return;
+    const auto byKey = [](const Posting& a, const Posting& b) { return a.key < b.key; };
+    sort(pending.begin(), pending.end(), byKey);
+    const vector<Posting> encoded = decode();
+    vector<Posting> merged(encoded.size() + pending.size());
+    merge(encoded.begin(), encoded.end(), pending.begin(), pending.end(), merged.begin(), byKey);
+    encode(merged);
+    pending.clear();
+}
+
+/**
+ * Blocks
+ *
+ * Block i starts after the key recorded as its before, so the block holding a
+ * key is the last one whose before is lower. Only the first block can have a
+ * before of 0 without any key below it, and a key of 0 belongs there too.
+ *
+ * Searches move forward through a list, so the block is found by galloping from
+ * a block known to start below key: doubling steps find a range that holds it,
+ * and a binary search of that range finds it, in time logarithmic in how far
+ * ahead it is rather than in the length of the list.
+ */
+uint32_t PostingList::blockFrom(uint32_t first, uint32_t key) const {
+    size_t low = first;
+    size_t high = first + 1;
+    for (size_t step = 1; high < blocks.size() && blocks[high].before < key; step *= 2) {
+        low = high;
+        high = low + step;
+    }
+    high = min(high, blocks.size());
+    const auto after = partition_point(blocks.begin() + low + 1, blocks.begin() + high,
+                                       [&](const Block& b) { return b.before < key; });
+    return static_cast<uint32_t>(after - blocks.begin() - 1);
+}
+
+uint32_t PostingList::blockOf(uint32_t key) const {
+    return blocks.empty() || blocks[0].before >= key ? 0 : blockFrom(0, key);
+}
+
+/**
+ * Appending a posting
+ *
+ * The posting is encoded into a local buffer first, so that if the list cannot
+ * grow it is left exactly as it was.
+ */
+void PostingList::append(uint32_t key, uint32_t frequency) {
+    uint8_t encoded[2 * maxVarintBytes];
+    size_t length = putVarint(encoded, (static_cast<uint64_t>(key - last) << 1) | (frequency != 1 ? 1 : 0));
+    if (frequency != 1) length += putVarint(encoded + length, frequency);
+
+    const bool starts = count % blockSize == 0;
+    if (starts) blocks.push_back({last, 0, bytes.size()});
+    try {
+        bytes.insert(bytes.end(), encoded, encoded + length);
+    } catch (...) {
+        if (starts) blocks.pop_back();
+        throw;
+    }
+    if (starts) {
+        if (blocks.size() > 1) blocks[blocks.size() - 2].maxFrequency = lastMaxFrequency;
+        lastMaxFrequency = 0;
+    }
+    lastMaxFrequency = max(lastMaxFrequency, frequency);
+    last = key;
+    count++;
+}
+
+vector<PostingList::Posting> PostingList::decode() const {
+    vector<Posting> postings;
+    postings.reserve(count);
+    for (Cursor cursor(*this); cursor.valid(); cursor.next()) {
+        postings.push_back({cursor.key(), cursor.frequency()});
+    }
+    return postings;
+}
+
+void PostingList::encode(const vector<Posting>& postings) {
+    PostingList encoded;
+    for (const Posting& posting : postings) {
+        encoded.append(posting.key, posting.frequency);
+    }
+    encoded.pending = std::move(pending);
+    *this = std::move(encoded);
+}
+
+PostingList::Cursor::Cursor(const PostingList& list, uint32_t block) : list(&list), index(block * blockSize) {
+    if (valid()) {
+        offset = list.blocks[block].offset;
+        current = list.blocks[block].before;
+        read();
+    }
+}
+
+void PostingList::Cursor::read() {
+    const uint8_t* at = list->bytes.data() + offset;
+    const uint64_t value = getVarint(at);
+    current += static_cast<uint32_t>(value >> 1);
+    currentFrequency = (value & 1) != 0 ? static_cast<uint32_t>(getVarint(at)) : 1;
+    offset = at - list->bytes.data();
+}
+
+void PostingList::Cursor::next() {
+    if (++index < list->count) read();
+}
+
+/**
+ * Seeking
+ *
+ * If target is in a later block the cursor jumps to the start of that block;
+ * either way it then steps one posting at a time, at most 64 of them.
+ */
+void PostingList::Cursor::seek(uint32_t target) {
+    if (!valid() || current >= target) return;
+    const auto& blocks = list->blocks;
+    const uint32_t block = index / blockSize;
+    if (block + 1 < blocks.size() && blocks[block + 1].before < target) {
+        const uint32_t to = list->blockFrom(block + 1, target);
+        index = to * blockSize;
+        offset = blocks[to].offset;
+        current = blocks[to].before;
+        read();
+    }
+    while (valid() && current < target) next();
+}
+
+PostingList::BlockBound PostingList::Cursor::boundFrom(uint32_t target) {
+    const auto& blocks = list->blocks;
+    if (target > list->last) return {0, numeric_limits<uint32_t>::max()};
+    // Targets normally only grow; one that does not starts again from the cursor
+    if (bounded < index / blockSize || blocks[bounded].before >= target) bounded = index / blockSize;
+    if (blocks[bounded].before < target) bounded = list->blockFrom(bounded, target);
+    if (bounded + 1 == blocks.size()) return {list->lastMaxFrequency, list->last};
+    return {blocks[bounded].maxFrequency, blocks[bounded + 1].before};
+}
+
+template <typename F>
+void TextIndex::forEachTerm(string_view text, F&& f) {
+    string term;
+    for (size_t i = 0; i < text.size();) {
+        if (!isWordByte(text[i])) {
+            i++;
+            continue;
+        }
+        term.clear();
+        for (; i < text.size() && isWordByte(text[i]); i++) {
+            const char c = text[i];
+            term.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c);
+        }
+        f(string_view(term), i);
+    }
+}
+
+template <typename F>
+void TextIndex::forEachText(const Item& item, F&& f) {
+    withConcreteItem(item, [&]<typename T>(const T& concrete) {
+        f(concrete.getName());
+        f(concrete.getDescription());
+        if constexpr (!is_same_v<T, Item>) {
+            f(concrete.getTitle());
+        }
+    });
+}
+
+size_t TextIndex::probe(uint32_t hash, string_view term) const {
+    const size_t mask = termSlots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const TermSlot& slot = termSlots[i];
+        if (slot.term == 0 || (slot.hash == hash && terms[slot.term - 1].text == term)) return i;
+    }
+}
+
+TextIndex::Term* TextIndex::find(string_view term) const {
+    if (termSlots.empty()) return nullptr;
+    const TermSlot& slot = termSlots[probe(hashTerm(term), term)];
+    return slot.term != 0 ? &terms[slot.term - 1] : nullptr;
+}
+
+/**
+ * Adding a term
+ *
+ * The table grows before the term is added rather than after, so that once the
+ * term is in terms and sortedTerms nothing can fail to leave it half-indexed.
+ */
+TextIndex::Term& TextIndex::intern(string_view term) {
+    const uint32_t hash = hashTerm(term);
+    if (!termSlots.empty()) {
+        const TermSlot& slot = termSlots[probe(hash, term)];
+        if (slot.term != 0) return terms[slot.term - 1];
+    }
+    if (terms.size() >= numeric_limits<uint32_t>::max() - 1) {
+        throw length_error("Text index is full");
+    }
+    if ((terms.size() + 1) * 4 > termSlots.size() * 3) {
+        vector<TermSlot> grown(max<size_t>(minimumTermSlots, termSlots.size() * 2));
+        const size_t mask = grown.size() - 1;
+        for (const TermSlot& slot : termSlots) {
+            if (slot.term == 0) continue;
+            size_t i = slot.hash & mask;
+            while (grown[i].term != 0) i = (i + 1) & mask;
+            grown[i] = slot;
+        }
+        termSlots = std::move(grown);
+    }
+
+    Term& added = terms.emplace_back(string(term));
+    try {
+        sortedTerms.emplace(added.text, &added);
+    } catch (...) {
+        terms.pop_back();
+        throw;
+    }
+    termSlots[probe(hash, term)] = {hash, static_cast<uint32_t>(terms.size())};
+    return added;
+}
+
+/**
+ * Adding an item
+ *
+ * The terms of all its text are collected and sorted first, so each distinct
+ * term is posted once with the number of times it occurs. If the index cannot
+ * grow part-way through, the postings already made are taken back.
+ */
+void TextIndex::add(const Item& item) {
+    const uint32_t key = PostingList::keyOf(item.getID());
+    itemTerms.clear();
+    forEachText(item, [&](string_view text) {
+        forEachTerm(text, [&](string_view term, size_t) { itemTerms.push_back(&intern(term)); });
+    });
+    sort(itemTerms.begin(), itemTerms.end());
+    try {
+        for (size_t i = 0; i < itemTerms.size();) {
+            size_t end = i + 1;
+            while (end < itemTerms.size() && itemTerms[end] == itemTerms[i]) end++;
+            itemTerms[i]->postings.add(key, static_cast<uint32_t>(end - i));
+            i = end;
+        }
+    } catch (const bad_alloc&) {
+        remove(item);
+        throw;
+    }
+}
+
+void TextIndex::remove(const Item& item) {
+    const uint32_t key = PostingList::keyOf(item.getID());
+    vector<Term*> removed;
+    forEachText(item, [&](string_view text) {
+        forEachTerm(text, [&](string_view term, size_t) {
+            if (Term* found = find(term)) removed.push_back(found);
+        });
+    });
+    sort(removed.begin(), removed.end());
+    removed.erase(unique(removed.begin(), removed.end()), removed.end());
+    for (Term* term : removed) {
+        term->postings.remove(key);
+    }
+}
+
+void TextIndex::flush() {
+    for (Term& term : terms) {
+        term.postings.flush();
+    }
+}
+
+void TextIndex::clear() {
+    sortedTerms.clear();
+    termSlots.clear();
+    terms.clear();
+}
+
+/**
+ * Searching
+ *
+ * Each query term becomes a Clause over the posting lists it matches. For an All
+ * search the clauses leapfrog: the shortest proposes a candidate, each of the
+ * others in turn moves to it, and one that overshoots makes its key the next
+ * target, so long lists are skipped through rather than read. An Any search
+ * reads every list as one Clause.
+ *
+ * Matches are ranked in a heap of the best limit found so far. Candidates come
+ * in ascending ID order, so once the heap is full a match has to score more
+ * than the worst one kept, not just as much. The block bounds of the clauses
+ * cap what any candidate up to the end of the nearest block can score, and if
+ * that is not enough the search moves past that block without decoding it.
+ */
+vector<TextMatch> TextIndex::search(string_view query, SearchMode mode, size_t limit) const {
+    // The terms each query term matches
+    vector<vector<PostingList*>> matched;
+    forEachTerm(query, [&](string_view term, size_t end) {
+        vector<PostingList*>& lists = matched.emplace_back();
+        if (end < query.size() && query[end] == '*') {
+            for (auto it = sortedTerms.lower_bound(term); it != sortedTerms.end() && it->first.starts_with(term); ++it) {
+                lists.push_back(&it->second->postings);
+            }
+        } else if (Term* found = find(term)) {
+            lists.push_back(&found->postings);
+        }
+    });
+
+    // An All search has a clause per query term, an Any search one clause over every list
+    vector<Clause> clauses(mode == SearchMode::All ? matched.size() : 1);
+    for (size_t i = 0; i < matched.size(); i++) {
+        Clause& clause = clauses[mode == SearchMode::All ? i : 0];
+        for (PostingList* list : matched[i]) {
+            list->flush();
+            if (list->size() != 0) clause.add(*list);
+        }
+    }
+    if (clauses.empty() || any_of(clauses.begin(), clauses.end(), [](const Clause& c) { return c.empty(); })) {
+        return {};
+    }
+    for (Clause& clause : clauses) clause.start();
+    sort(clauses.begin(), clauses.end(), [](const Clause& a, const Clause& b) { return a.size() < b.size(); });
+
+    vector<TextMatch> best;
+    const auto better = [](const TextMatch& a, const TextMatch& b) {
+        return a.score != b.score ? a.score > b.score : a.id < b.id;
+    };
+    const auto collect = [&](uint32_t key, uint32_t score) {
+        const TextMatch match{PostingList::idOf(key), score};
+        if (limit == 0 || best.size() < limit) {
+            best.push_back(match);
+            if (limit != 0) push_heap(best.begin(), best.end(), better);
+        } else if (better(match, best.front())) {
+            // The front of the heap is the worst match kept
+            pop_heap(best.begin(), best.end(), better);
+            best.back() = match;
+            push_heap(best.begin(), best.end(), better);
+        }
+    };
+
+    const bool prunable = limit != 0 && all_of(clauses.begin(), clauses.end(), [](const Clause& c) { return c.bounded(); });
+    // Highest score of any candidate up to boundEnd, worked out again once candidate passes it
+    uint64_t bound = 0;
+    uint32_t boundEnd = 0;
+    bool haveBound = false;
+
+    constexpr uint32_t lastKey = numeric_limits<uint32_t>::max();
+    for (uint32_t candidate = 0;;) {
+        // The shortest clause proposes each candidate
+        Clause& lead = clauses.front();
+        lead.seek(candidate);
+        if (!lead.valid()) break;
+        candidate = lead.key();
+
+        if (prunable && best.size() == limit) {
+            if (!haveBound || candidate > boundEnd) {
+                bound = 0;
+                boundEnd = lastKey;
+                for (Clause& clause : clauses) {
+                    const auto block = clause.boundFrom(candidate);
+                    bound += block.maxFrequency;
+                    boundEnd = min(boundEnd, block.last);
+                }
+                haveBound = true;
+            }
+            if (bound <= best.front().score) {
+                if (boundEnd == lastKey) break;
+                candidate = boundEnd + 1;
+                continue;
+            }
+        }
+
+        bool finished = false;
+        bool agreed = true;
+        for (size_t i = 1; i < clauses.size() && agreed; i++) {
+            clauses[i].seek(candidate);
+            if (!clauses[i].valid()) {
+                finished = true;
+                break;
+            }
+            if (clauses[i].key() != candidate) {
+                candidate = clauses[i].key();
+                agreed = false;
+            }
+        }
+        if (finished) break;
+        if (!agreed) continue;
+
+        uint32_t score = 0;
+        for (Clause& clause : clauses) score += clause.take();
+        collect(candidate, score);
+        if (candidate == lastKey) break;
+        candidate++;
+    }
+
+    sort(best.begin(), best.end(), better);
+    return best;
+}
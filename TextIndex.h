@@ -0,0 +1,253 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef TEXTINDEX_H
+#define TEXTINDEX_H
+
+#include "Item.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/// How the terms of a keyword search are combined
+enum class SearchMode : uint8_t {
+    All, ///< An item must contain every term
+    Any  ///< An item must contain at least one term
+};
+
+/// One item found by a keyword search
+struct TextMatch {
+    ItemId id;
+    uint32_t score; ///< Number of times the query terms occur in the item's text
+};
+
+/**
+ * @class PostingList
+ * @brief The items that contain one term, as a sorted, delta-encoded list
+ *
+ * Items are kept in ascending order of a key that orders like their IDs. Each
+ * posting is the difference from the previous key, shifted left once with the
+ * low bit set if a term frequency other than 1 follows, as a varint; most
+ * postings take one or two bytes. The list is cut into blocks of 64 postings,
+ * and each block records where it starts and the highest frequency in it, so
+ * a Cursor can skip ahead without decoding everything in between and a search
+ * can pass over blocks that cannot make its results.
+ *
+ * New IDs are normally the largest yet and are appended directly. One that is
+ * not waits in a small unsorted list until flush() merges it in, which happens
+ * once that list is a quarter of the size of the encoded one or before a search.
+ */
+class PostingList {
+public:
+    /// Order-preserving map from an item ID to its key
+    static uint32_t keyOf(ItemId id) { return static_cast<uint32_t>(id) ^ 0x80000000u; }
+    static ItemId idOf(uint32_t key) { return static_cast<ItemId>(key ^ 0x80000000u); }
+
+    /// @brief Records that the item with key contains the term frequency times
+    void add(uint32_t key, uint32_t frequency);
+
+    /// @brief Forgets the item with key; an item that is not in the list is ignored
+    void remove(uint32_t key);
+
+    /// @brief Merges the postings that arrived out of order into the encoded list
+    void flush();
+
+    /// @return Number of items in the list
+    size_t size() const { return count + pending.size(); }
+
+    /// The keys of a block, and the highest frequency among them
+    struct BlockBound {
+        uint32_t maxFrequency;
+        uint32_t last; ///< Last key of the block
+    };
+
+    /**
+     * @class Cursor
+     * @brief Reads the encoded postings in key order; postings not yet flushed are not seen
+     */
+    class Cursor {
+    public:
+        explicit Cursor(const PostingList& list) : Cursor(list, 0) {}
+
+        bool valid() const { return index < list->count; }
+        uint32_t key() const { return current; }
+        uint32_t frequency() const { return currentFrequency; }
+
+        /// @brief Moves to the next posting
+        void next();
+
+        /// @brief Moves forward to the first posting whose key is at least target
+        void seek(uint32_t target);
+
+        /**
+         * @brief Bounds the block that holds target, which must not be before key()
+         * @return Its highest frequency and last key, or a frequency of 0 up to
+         *         the largest key if target is past the end of the list
+         *
+         * Does not move the cursor, but remembers the block, so bounding targets
+         * in ascending order walks the blocks once.
+         */
+        BlockBound boundFrom(uint32_t target);
+
+    private:
+        friend class PostingList;
+
+        /// @brief Starts at the first posting of a block
+        Cursor(const PostingList& list, uint32_t block);
+
+        const PostingList* list;
+        uint32_t index = 0;   ///< Number of the current posting
+        size_t offset = 0;    ///< Where the posting after the current one starts
+        uint32_t current = 0;
+        uint32_t currentFrequency = 0;
+        uint32_t bounded = 0; ///< Block last bounded
+
+        void read();
+    };
+
+private:
+    /// Where block i, holding postings [64 * i, 64 * (i + 1)), starts
+    struct Block {
+        uint32_t before;       ///< Key of the posting before it, or 0 for the first block
+        uint32_t maxFrequency; ///< Highest frequency in it
+        size_t offset;         ///< Where it starts in bytes
+    };
+
+    struct Posting {
+        uint32_t key;
+        uint32_t frequency;
+    };
+
+    vector<uint8_t> bytes;
+    vector<Block> blocks;    ///< The last block's maxFrequency is only set once it is full; see lastMaxFrequency
+    vector<Posting> pending; ///< Postings with keys below last, unsorted
+    uint32_t count = 0;      ///< Number of encoded postings
+    uint32_t last = 0;       ///< Key of the last encoded posting
+    uint32_t lastMaxFrequency = 0; ///< Highest frequency in the last block, kept here so appending stays in this object
+
+    /// @return The block key would be in, searching forward from block first, which must start below key
+    uint32_t blockFrom(uint32_t first, uint32_t key) const;
+
+    /// @return The block key would be in
+    uint32_t blockOf(uint32_t key) const;
+
+    void append(uint32_t key, uint32_t frequency);
+    vector<Posting> decode() const;
+    void encode(const vector<Posting>& postings);
+};
+
+/**
+ * @class TextIndex
+ * @brief Inverted index from the words of item names, descriptions and titles to
+ *        the items that contain them
+ *
+ * Text is split into terms at every character that is not an ASCII letter or
+ * digit, and ASCII letters are folded to lower case; bytes of multi-byte UTF-8
+ * characters are kept as they are, so accented words are still terms. Each
+ * term has a PostingList of the items containing it and how often.
+ *
+ * Searching joins the posting lists of the query terms, leapfrogging through
+ * them from the shortest for an All search, and ranks the items by how many
+ * times the terms occur in them. Once it has as many matches as it was asked
+ * for, it skips the blocks whose highest frequencies add up to no more than
+ * the worst of them, so a common term does not have to be read to the end. A
+ * query term ending in '*' matches every term it is a prefix of, found through
+ * a sorted copy of the vocabulary.
+ */
+class TextIndex {
+public:
+    /**
+     * @brief Adds the words of item to the index
+     * @throws invalid_argument if item is not exactly an Item, Book, Magazine or Movie
+     * @throws bad_alloc if the index cannot grow; item is then in no posting list
+     */
+    void add(const Item& item);
+
+    /// @brief Removes item from the index; an item that was never added is ignored
+    void remove(const Item& item);
+
+    /// @brief Empties the index
+    void clear();
+
+    /**
+     * @brief Merges the postings that arrived out of order into every list
+     *
+     * search does this for the lists it reads anyway; calling it after adding
+     * many items in no particular order saves the first searches the work.
+     */
+    void flush();
+
+    /**
+     * @brief Finds the items that match a keyword query
+     * @param query Words separated by spaces or punctuation; a word directly
+     *        followed by '*' matches every word that starts with it
+     * @param mode Whether an item needs all of the words or any of them
+     * @param limit Most matches to return, or 0 for all of them
+     * @return Matches by descending score, then ascending ID
+     *
+     * Const for callers, but merges the pending postings of the terms it reads,
+     * so it must not run concurrently with itself or with add.
+     */
+    vector<TextMatch> search(string_view query, SearchMode mode, size_t limit) const;
+
+private:
+    /// A term and the items that contain it
+    struct Term {
+        string text;
+        PostingList postings;
+    };
+
+    /// Slot of the term table; term is one more than the term's index, so 0 marks an empty slot
+    struct TermSlot {
+        uint32_t hash = 0;
+        uint32_t term = 0;
+    };
+
+    /**
+     * Every term, in the order first seen. A deque never moves its elements, so
+     * sortedTerms can view their text and add can hold on to them. Mutable so
+     * that search can flush the lists it reads.
+     */
+    mutable deque<Term> terms;
+
+    /**
+     * Open-addressing table of (hash, term) pairs, laid out like the one in
+     * SymbolTable: probing compares the stored hash first, so a lookup reads
+     * the term itself, whose posting list it is about to append to, and little else.
+     */
+    vector<TermSlot> termSlots;
+
+    /// The same terms in order, for prefix queries
+    map<string_view, Term*> sortedTerms;
+
+    /// Terms of the item being added, reused to avoid allocating per item
+    vector<Term*> itemTerms;
+
+    /// @brief Calls f(term, end) for every term of text, where end is the offset just past it
+    template <typename F>
+    static void forEachTerm(string_view text, F&& f);
+
+    /// @brief Calls f(text) for the name, description and title of item
+    template <typename F>
+    static void forEachText(const Item& item, F&& f);
+
+    /// @return Index in termSlots of term's slot, or of the empty slot it would go in
+    size_t probe(uint32_t hash, string_view term) const;
+
+    /// @return The term, or nullptr if no item has it
+    Term* find(string_view term) const;
+
+    /// @return The term, added if no item had it yet
+    Term& intern(string_view term);
+};
+
+#endif //TEXTINDEX_H
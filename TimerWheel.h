@@ -0,0 +1,201 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/// Identifies a timer in a TimerWheel
+using TimerHandle = uint32_t;
+
+/// A handle that refers to no timer
+constexpr TimerHandle noTimer = numeric_limits<TimerHandle>::max();
+
+/**
+ * @class TimerWheel
+ * @brief Hierarchical timing wheel that fires a payload at an integer time
+ * @tparam Payload What a timer carries back to its owner when it fires
+ *
+ * Time is an integer tick, such as a day number. The wheel has six levels of 64
+ * slots; a slot on level L covers 64^L ticks, and a timer sits on the lowest
+ * level on which it is in a different slot from the current time, so level 0
+ * holds the timers due within the current run of 64 ticks, level 1 those within
+ * the current run of 4096, and so on. Scheduling and cancelling only link or
+ * unlink a node, whatever the number of timers. Each tick fires one level-0
+ * slot, and whenever the low digits of the time roll over, the next slot of the
+ * level above is spread over the levels below it; a timer is moved at most
+ * once per level, so a tick does work in proportion to the timers that expire
+ * rather than to all of them.
+ *
+ * Nodes live in one vector and are linked by index, with freed nodes reused, so
+ * a Handle stays valid until its timer fires or is cancelled, after which the
+ * owner must forget it.
+ */
+template <typename Payload>
+class TimerWheel {
+public:
+    using Handle = TimerHandle;
+    static constexpr Handle none = noTimer;
+
+    /// @brief Starts the wheel at time now
+    explicit TimerWheel(int32_t now = 0) : current(now) { heads.fill(none); }
+
+    /// @return The time the wheel has advanced to
+    int32_t now() const { return current; }
+
+    /// @return Number of timers that have not fired or been cancelled
+    size_t size() const { return live; }
+
+    /**
+     * @brief Schedules payload to fire at time when
+     * @return Handle with which the timer can be cancelled
+     * @throws bad_alloc if the wheel cannot grow; it is then unchanged
+     *
+     * A timer scheduled at or before now() fires on the next advance.
+     */
+    Handle schedule(int32_t when, Payload payload) {
+        Handle handle = freeNodes;
+        if (handle == none) {
+            handle = static_cast<Handle>(nodes.size());
+            nodes.push_back(Node{when, none, none, 0, std::move(payload)});
+        } else {
+            freeNodes = nodes[handle].next;
+            nodes[handle].when = when;
+            nodes[handle].payload = std::move(payload);
+        }
+        link(handle, bucketOf(when));
+        live++;
+        return handle;
+    }
+
+    /// @brief Cancels a timer that has not fired yet
+    void cancel(Handle handle) noexcept {
+        unlink(handle);
+        release(handle);
+    }
+
+    /**
+     * @brief Advances the wheel to time to, firing every timer due by then
+     * @param fire Called as fire(when, payload) for each timer
+     *
+     * Timers fire tick by tick, in order of time, except that those already due
+     * when the call starts fire first and in no particular order. fire may
+     * schedule and cancel timers; one it schedules at or before to fires in this
+     * same call. Moving the wheel backwards only fires the timers already due.
+     */
+    template <typename F>
+    void advance(int32_t to, F&& fire) {
+        fireBucket(expired, fire);
+        while (current < to) {
+            if (live == 0) {
+                current = to;
+                break;
+            }
+            current++;
+            const auto time = static_cast<uint32_t>(current);
+            // Spread the slots whose range starts now, from the highest level down
+            int top = 0;
+            while (top + 1 < levels && (time & ((1u << (levelBits * (top + 1))) - 1)) == 0) top++;
+            for (int level = top; level >= 1; level--) {
+                cascade(level * slotsPerLevel + ((time >> (levelBits * level)) & (slotsPerLevel - 1)));
+            }
+            fireBucket(time & (slotsPerLevel - 1), fire);
+            fireBucket(expired, fire);
+        }
+    }
+
+    /// @brief Cancels every timer
+    void clear() {
+        nodes.clear();
+        heads.fill(none);
+        freeNodes = none;
+        live = 0;
+    }
+
+private:
+    static constexpr int levelBits = 6;
+    static constexpr int slotsPerLevel = 1 << levelBits;
+    static constexpr int levels = 6; ///< Enough to cover 32-bit times
+    /// Bucket of the timers due at or before the current time
+    static constexpr uint16_t expired = levels * slotsPerLevel;
+
+    struct Node {
+        int32_t when;
+        Handle previous; ///< Previous node in the bucket, or none if this is its first
+        Handle next;     ///< Next node in the bucket, or the next free node
+        uint16_t bucket;
+        Payload payload;
+    };
+
+    vector<Node> nodes;
+    array<Handle, levels * slotsPerLevel + 1> heads; ///< First node of each bucket
+    Handle freeNodes = none;
+    int32_t current;
+    size_t live = 0;
+
+    uint16_t bucketOf(int32_t when) const {
+        if (when <= current) return expired;
+        // The highest digit in which when differs from now picks the level
+        const uint32_t differ = static_cast<uint32_t>(when) ^ static_cast<uint32_t>(current);
+        const int level = (bit_width(differ) - 1) / levelBits;
+        const uint32_t slot = (static_cast<uint32_t>(when) >> (levelBits * level)) & (slotsPerLevel - 1);
+        return static_cast<uint16_t>(level * slotsPerLevel + slot);
+    }
+
+    void link(Handle handle, uint16_t bucket) noexcept {
+        Node& node = nodes[handle];
+        node.bucket = bucket;
+        node.previous = none;
+        node.next = heads[bucket];
+        if (node.next != none) nodes[node.next].previous = handle;
+        heads[bucket] = handle;
+    }
+
+    void unlink(Handle handle) noexcept {
+        const Node& node = nodes[handle];
+        if (node.previous != none) nodes[node.previous].next = node.next;
+        else heads[node.bucket] = node.next;
+        if (node.next != none) nodes[node.next].previous = node.previous;
+    }
+
+    void release(Handle handle) noexcept {
+        nodes[handle].payload = Payload();
+        nodes[handle].next = freeNodes;
+        freeNodes = handle;
+        live--;
+    }
+
+    void cascade(uint16_t bucket) noexcept {
+        Handle handle = exchange(heads[bucket], none);
+        while (handle != none) {
+            const Handle next = nodes[handle].next;
+            link(handle, bucketOf(nodes[handle].when));
+            handle = next;
+        }
+    }
+
+    // Takes one timer at a time, so fire can cancel the others in the bucket
+    template <typename F>
+    void fireBucket(uint16_t bucket, F& fire) {
+        while (heads[bucket] != none) {
+            const Handle handle = heads[bucket];
+            unlink(handle);
+            const int32_t when = nodes[handle].when;
+            Payload payload = std::move(nodes[handle].payload);
+            release(handle);
+            fire(when, std::move(payload));
+        }
+    }
+};
+
+#endif //TIMERWHEEL_H
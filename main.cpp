@@ -1,5 +1,10 @@
 
+#include "CatalogImport.h"
+#include "Checkpoint.h"
 #include "Inventory.h"
+#include "Journal.h"
+#include <atomic>
+#include <filesystem>
 #include <limits>
 
 using namespace std;
@@ -24,27 +29,63 @@ string getLineInput(const string& prompt) {
     return input;
 }
 
-Position getPositionInput() {
+Position getPositionInput(const Inventory& inv) {
     int shelf, compartment;
+    const string shelfRange = "0-" + to_string(inv.getShelfCount() - 1);
+    const string compartmentRange = "0-" + to_string(inv.getCompartmentsPerShelf() - 1);
     
-    shelf = getValidIntInput("Enter shelf number (0-2): ");
-    while (shelf < 0 || shelf >= 3) {
-        shelf = getValidIntInput("Invalid shelf. Please enter a number between 0-2: ");
+    shelf = getValidIntInput("Enter shelf number (" + shelfRange + "): ");
+    while (shelf < 0 || shelf >= inv.getShelfCount()) {
+        shelf = getValidIntInput("Invalid shelf. Please enter a number between " + shelfRange + ": ");
     }
     
-    compartment = getValidIntInput("Enter compartment number (0-14): ");
-    while (compartment < 0 || compartment >= 15) {
-        compartment = getValidIntInput("Invalid compartment. Please enter a number between 0-14: ");
+    compartment = getValidIntInput("Enter compartment number (" + compartmentRange + "): ");
+    while (compartment < 0 || compartment >= inv.getCompartmentsPerShelf()) {
+        compartment = getValidIntInput("Invalid compartment. Please enter a number between " + compartmentRange + ": ");
     }
     
     return Position(shelf, compartment);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     // Create inventory
     Inventory inv;
     int menuChoice;
-    int nextId = 1000; // Starting ID for items
+    // Starting ID for items; the background checkpoints read it too
+    atomic<int> nextId = 1000;
+
+    // Restore the last checkpoint and the changes journaled since
+    const string snapshotPath = "inventory.snap";
+    const string journalPath = "inventory.journal";
+    if (filesystem::exists(snapshotPath)) {
+        nextId = max(nextId.load(), inv.loadSnapshot(snapshotPath));
+    }
+    const size_t replayed = inv.replayJournal(journalPath);
+    if (replayed != 0) {
+        cout << "Replayed " << replayed << " journaled changes" << endl;
+    }
+    if (const auto highest = inv.highestItemId()) {
+        nextId = max(nextId.load(), *highest + 1);
+    }
+    Journal journal(journalPath);
+    inv.attachJournal(&journal);
+
+    // Checkpoint the changed shelves in the background, which also keeps the
+    // journal, and so the next startup's replay, short
+    Checkpointer checkpointer([&] { inv.checkpoint(snapshotPath, {.nextId = nextId}); }, chrono::seconds(30));
+
+    // Optionally preload a CSV/TSV catalog given on the command line
+    if (argc > 1) {
+        try {
+            const size_t count = importCatalog(inv, argv[1]);
+            if (const auto highest = inv.highestItemId()) {
+                nextId = max(nextId.load(), *highest + 1);
+            }
+            cout << "Imported " << count << " items from " << argv[1] << endl;
+        } catch (const exception& e) {
+            cout << "Error importing catalog: " << e.what() << endl;
+        }
+    }
 
     do {
         cout
@@ -57,6 +98,8 @@ int main() {
         << "6. Swap Items\n"
         << "7. Print All Items\n"
         << "8. Print Checked Out Items\n"
+        << "9. Save Checkpoint\n"
+        << "10. Search Items\n"
         << "0. Exit\n"
         << "=======================================\n"
         << "Enter your choice: ";
@@ -75,10 +118,10 @@ int main() {
                     string author = getLineInput("Enter author: ");
                     string copyright = getLineInput("Enter copyright date: ");
 
-                    Book book(name, description, nextId++, title, author, copyright);
-                    Position pos = getPositionInput();
+                    Book book(move(name), move(description), nextId++, move(title), move(author), move(copyright));
+                    Position pos = getPositionInput(inv);
 
-                    inv.addItem(pos, book);
+                    inv.addItem(pos, move(book));
                     cout << "Book added successfully!" << endl;
                     break;
                 }
@@ -89,10 +132,10 @@ int main() {
                     string edition = getLineInput("Enter edition: ");
                     string title = getLineInput("Enter title of main article: ");
 
-                    Magazine magazine(name, description, nextId++, edition, title);
-                    Position pos = getPositionInput();
+                    Magazine magazine(move(name), move(description), nextId++, move(edition), move(title));
+                    Position pos = getPositionInput(inv);
 
-                    inv.addItem(pos, magazine);
+                    inv.addItem(pos, move(magazine));
                     cout << "Magazine added successfully!" << endl;
                     break;
                 }
@@ -107,13 +150,13 @@ int main() {
                     vector<string> actors;
                     for (int i = 0; i < numActors; i++) {
                         string actor = getLineInput("Enter actor " + to_string(i+1) + ": ");
-                        actors.push_back(actor);
+                        actors.push_back(move(actor));
                     }
 
-                    Movie movie(name, description, nextId++, title, director, actors);
-                    Position pos = getPositionInput();
+                    Movie movie(move(name), move(description), nextId++, move(title), move(director), move(actors));
+                    Position pos = getPositionInput(inv);
 
-                    inv.addItem(pos, movie);
+                    inv.addItem(pos, move(movie));
                     cout << "Movie added successfully!" << endl;
                     break;
                 }
@@ -129,22 +172,18 @@ int main() {
                 }
 
                 case 5: { // Check In Item
-                    string itemId = getLineInput("Enter item ID to check in: ");
-                    int id = stoi(itemId);
-
-                    // Create a dummy item with just the ID for checking in
-                    Item dummyItem("", "", id);
-                    inv.checkinItem(dummyItem);
+                    const int itemId = getValidIntInput("Enter item ID to check in: ");
+                    inv.checkinItem(itemId);
                     cout << "Item checked in successfully!" << endl;
                     break;
                 }
 
                 case 6: { // Swap Items
                     cout << "First position:" << endl;
-                    Position pos1 = getPositionInput();
+                    Position pos1 = getPositionInput(inv);
 
                     cout << "Second position:" << endl;
-                    Position pos2 = getPositionInput();
+                    Position pos2 = getPositionInput(inv);
 
                     inv.swapItems(pos1, pos2);
                     cout << "Items swapped successfully!" << endl;
@@ -153,9 +192,37 @@ int main() {
                 case 7: // Print All Items
                     cout << inv;
                     break;
-                case 8: // Print Checked Out Items
-                    inv.printCheckedOutItems();
+                case 8: { // Print Checked Out Items
+                    string patron = getLineInput("Enter patron name (leave blank for everyone): ");
+                    if (patron.empty()) {
+                        inv.printCheckedOutItems();
+                    } else if (const auto id = inv.findPatron(patron)) {
+                        inv.printCheckedOutItems(*id);
+                    } else {
+                        cout << "No patron named " << patron << " has checked anything out." << endl;
+                    }
                     break;
+                }
+
+                case 9: // Save Checkpoint
+                    inv.checkpoint(snapshotPath, {.nextId = nextId});
+                    cout << "Checkpoint saved successfully!" << endl;
+                    break;
+
+                case 10: { // Search Items
+                    string query = getLineInput("Enter keywords (end a word with * to match its prefix): ");
+                    string mode = getLineInput("Match all keywords or any? (all/any): ");
+                    const auto hits = inv.searchText(query, mode == "any" ? SearchMode::Any : SearchMode::All);
+                    if (hits.empty()) {
+                        cout << "No items found." << endl;
+                    }
+                    for (const auto& [location, score] : hits) {
+                        cout << "Item " << location.id << " at shelf " << location.position.getRow()
+                             << ", compartment " << location.position.getCol()
+                             << (location.checkedOut ? " (checked out)" : "") << ", score " << score << endl;
+                    }
+                    break;
+                }
 
                 default:
                     cout << "Invalid choice. Please try again." << endl;
@@ -0,0 +1,62 @@
+//
+// Created by Jawad Khadra on 5/5/25.
+//
+
+#include "Inventory.h"
+#include "Snapshot.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+using namespace std;
+
+/**
+ * Flips every bit of a small snapshot, one at a time, and checks that each
+ * damaged copy is refused. Bits in the shelf blocks, the checkout block and the
+ * dictionary are covered as well as the header, including bytes inside strings,
+ * which decode cleanly unless their block's checksum is checked.
+ */
+int main() {
+    const filesystem::path directory = filesystem::temp_directory_path();
+    const string original = (directory / "snapshot-corruption.snap").string();
+    const string damaged = (directory / "snapshot-corruption-damaged.snap").string();
+
+    Inventory inventory(2, 4);
+    inventory.addItem(Position(0, 0), Book("Dune", "Desert planet", 1, "Dune", "Frank Herbert", "1965"));
+    inventory.addItem(Position(0, 1), Magazine("Wired", "Technology", 2, "May", "Wired"));
+    inventory.addItem(Position(1, 2), Movie("Alien", "Space horror", 3, "Alien", "Ridley Scott", {"Sigourney Weaver"}));
+    inventory.checkoutItem("2", "reader");
+    inventory.saveSnapshot(original, 4);
+
+    ifstream in(original, ios::binary);
+    const string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+
+    // The snapshot as written must load
+    Inventory reloaded(1, 1);
+    if (reloaded.loadSnapshot(original) != 4 || !reloaded.isItemCheckedOut(2)) {
+        cerr << "Undamaged snapshot did not load back" << endl;
+        return 1;
+    }
+
+    size_t accepted = 0;
+    for (size_t bit = 0; bit < bytes.size() * 8; bit++) {
+        string copy = bytes;
+        copy[bit / 8] = static_cast<char>(copy[bit / 8] ^ (1 << (bit % 8)));
+        ofstream(damaged, ios::binary | ios::trunc).write(copy.data(), static_cast<streamsize>(copy.size()));
+        try {
+            Inventory target(1, 1);
+            target.loadSnapshot(damaged);
+            cerr << "Flipped bit " << bit << " (byte " << bit / 8 << ") was not detected" << endl;
+            accepted++;
+        } catch (const runtime_error&) {
+            // Expected
+        }
+    }
+
+    filesystem::remove(original);
+    filesystem::remove(damaged);
+    cout << bytes.size() * 8 << " bit flips, " << accepted << " accepted" << endl;
+    return accepted == 0 ? 0 : 1;
+}